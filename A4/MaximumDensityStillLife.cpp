@@ -2,6 +2,25 @@
 #include <gecode/driver.hh>
 #include <gecode/int.hh>
 #include <gecode/minimodel.hh>
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "pool-alloc.cpp"
+#include "solver-options.cpp"
+#include "estimate.cpp"
+#include "search-monitor.cpp"
+#include "heartbeat.cpp"
+#include "perf-counters.cpp"
+#include "search-histogram.cpp"
+#include "deterministic.cpp"
+#include "output-writer.cpp"
+#include "portfolio.cpp"
+#include "census.cpp"
+#include "shave.cpp"
 
 using namespace Gecode;
 
@@ -23,17 +42,46 @@ private:
   IntVar noOfLives;
   int board_size;
   
+  /*
+   * phase saving: the value each cell was last assigned on any branch (or in the
+   * hints), -1 for none yet; shared by the clones of a search, so that it survives
+   * failures and restarts
+   */
+  SharedArray<int> phase;
+  
 public:
+    
+    enum {
+        MODEL_LINEAR, MODEL_EXTENSIONAL
+    };
+    
+    enum {
+        BRANCH_NONE, BRANCH_AFC, BRANCH_ACTIVITY
+    };
 
-    MaximumDensityStillLife(const SizeOptions& os) :
-    cells(*this,(os.size()+4)*(os.size()+4),0,1), sliceOfMDP(*this,pow(ceil(os.size()/3.0),2),0,6), noOfLives(*this,0,pow(os.size(), 2))
+    MaximumDensityStillLife(const SolverOptions& os, Census* census = NULL) :
+    MaximumDensityStillLife(os, os.model(), census) {}
+    
+    MaximumDensityStillLife(const SolverOptions& os, int model, Census* census = NULL) :
+    cells(*this,(os.size()+4)*(os.size()+4),0,1), sliceOfMDP(*this,pow(ceil(os.size()/3.0),2),0,6), noOfLives(*this,0,pow(os.size(), 2)),
+    phase((os.size()+4)*(os.size()+4))
     {
+        for (int i = 0; i < phase.size(); i++)
+            phase[i] = -1;
         //board size plus a border of size two around the pattern
         this -> board_size = os.size()+4;
         
           Matrix<BoolVarArgs> matrix(cells, board_size, board_size);
+          
+          Census::variables(census, "cells", cells.size());
+          Census::variables(census, "sliceOfMDP", sliceOfMDP.size());
+          Census::variables(census, "noOfLives", 1);
+          if (model == MODEL_LINEAR)
+              Census::variables(census, "live_neighbours", os.size()*os.size());
+          Census::mark(census, *this, "number of lives");
 
           rel(*this, sum(cells) == noOfLives);
+          Census::mark(census, *this, "dead border");
           
 //          constraint on border of size two around the pattern and set it to empty.
           linear(*this, matrix.slice(0, 2, 0, board_size), IRT_EQ, 0);// First 2 rows
@@ -41,60 +89,182 @@ public:
           linear(*this, matrix.slice(2, board_size-2, 0, 2), IRT_EQ, 0);// First 2 columns         
           linear(*this, matrix.slice(2, board_size-2, board_size-2, board_size), IRT_EQ, 0);// Last 2 columns
           
+          /*
+           * offsets of the eight neighbours of a cell in cells (above, side, below), so
+           * that a neighbourhood is gathered without building a matrix per cell
+           */
+          const int neighbour[8] = {
+              -board_size-1, -board_size, -board_size+1,
+              -1, 1,
+              board_size-1, board_size, board_size+1
+          };
+          
+          /*
+           * the still life rules as a table over a cell and its eight neighbours (in
+           * that order), for the extensional model
+           */
+          TupleSet rules;
+          if (model == MODEL_EXTENSIONAL) {
+              IntArgs tuple(9);
+              for (int t = 0; t < 512; t++) {
+                  int live = 0;
+                  for (int k = 0; k < 9; k++) {
+                      tuple[k] = (t >> k) & 1;
+                      if (k > 0)
+                          live += tuple[k];
+                  }
+                  if (tuple[0] == 1 ? (live == 2 || live == 3) : (live != 3))
+                      rules.add(tuple);
+              }
+              rules.finalize();
+          }
+          
           int blockNo = 0;
           for (int col = 2; col < board_size - 2; col++) {
               for (int row = 2; row < board_size - 2 ; row++) {
+                  int cell = col + row*board_size;
                   
                   // neighbours of cell(col, row)
-                  BoolVarArgs neighbours = getNeighbours(col, row);
-                  
-                  BoolVar two_neighbours(*this,0,1);
-                  BoolVar three_neighbours(*this,0,1);
-                  BoolVar still_live(*this,0,1);
+                  BoolVarArgs neighbours(8);
+                  for (int k = 0; k < 8; k++)
+                      neighbours[k] = cells[cell + neighbour[k]];
                   
+                  Census::mark(census, *this, model == MODEL_EXTENSIONAL ?
+                               "still life rules (extensional)" : "still life rules (linear, reified dom and rel)");
                   /* still life constraints:
                    *    A live cell with two or three live neighbours is alive in the next generation.
                    *    A dead cell must not have 3 neighbours to stay dead in next generation
                    */ 
-                  linear(*this,neighbours,IRT_EQ,2,two_neighbours);
-                  linear(*this,neighbours,IRT_EQ,3,three_neighbours);
-                  rel(*this,two_neighbours,BOT_OR,three_neighbours,still_live); 
-                  rel(*this, (matrix(col,row) >> still_live));
-                  rel(*this, (!matrix(col,row) >> !three_neighbours));
+                  if (model == MODEL_EXTENSIONAL) {
+                      BoolVarArgs hood(9);
+                      hood[0] = cells[cell];
+                      for (int k = 0; k < 8; k++)
+                          hood[k+1] = neighbours[k];
+                      extensional(*this, hood, rules);
+                  } else {
+                      IntVar live_neighbours(*this,0,8);
+                      linear(*this,neighbours,IRT_EQ,live_neighbours);
+                      dom(*this,live_neighbours,2,3,Reify(cells[cell],RM_IMP));
+                      rel(*this,live_neighbours,IRT_EQ,3,Reify(cells[cell],RM_PMI));
+                  }
                   
                   /*constraint on 3*3 blocks
-                   *    the maximum number of lives cells is 6.
+                   *    the maximum number of lives cells is 6, less for blocks cut off by
+                   *    the border or lying along it (see blockBound).
                    */
                   if (col % 3 == 2 && row % 3 == 2) {
+                      Census::mark(census, *this, "3x3 block bounds");
                       linear(*this, matrix.slice(col, col+3, row, row+3), IRT_EQ, sliceOfMDP[blockNo]);
+                      int w = std::min(3, board_size-2-col);
+                      int h = std::min(3, board_size-2-row);
+                      rel(*this, sliceOfMDP[blockNo] <= blockBound(w, h, col == 2, col+w == board_size-2,
+                                                                  row == 2, row+h == board_size-2));
                       blockNo++;
                   }
               }
               
 //              constraint on the inner-most border cells to have less than 3 neighbours,so they will stay dead
+              Census::mark(census, *this, "inner border");
               linear(*this,matrix.slice (2, 3, col, col+3), IRT_LE, 3);
               linear(*this,matrix.slice (col, col+3, 2, 3), IRT_LE, 3);
               linear(*this,matrix.slice (board_size-3, board_size-2, col, col+ 3), IRT_LE, 3);
               linear(*this,matrix.slice (col, col+3, board_size-3, board_size-2), IRT_LE, 3);
           }
            
-          branch(*this, cells, INT_VAR_NONE(), INT_VAL_MAX());
+          // the blocks tile the board, so their bounds bound the number of lives
+          Census::mark(census, *this, "3x3 block bounds");
+          linear(*this, sliceOfMDP, IRT_EQ, noOfLives);
+          
+          /*
+           * Known optimum for this board size (if a table is given and has it): an upper bound for the
+           * number of lives, or in verify mode the number of lives itself, so that
+           * the first solution found is the optimal one.
+           */
+          int known = knownOptimum(os.optima(), os.size());
+          Census::mark(census, *this, "known optimum");
+          if (known >= 0) {
+              if (os.verify())
+                  rel(*this, noOfLives == known);
+              else
+                  rel(*this, noOfLives <= known);
+          }
+           
+          /*
+           * Cells in memory order, or the cell with the largest accumulated failure count
+           * or activity first (both decayed, so that after a restart search moves on
+           * to the regions of the board that caused the most trouble lately).
+           * A cell is made alive first, or with -phase takes its saved phase first.
+           */
+          Census::mark(census, *this, "branching");
+          IntValBranch value = os.phase() ? INT_VAL(&phaseCell, &commitCell) : INT_VAL_MAX();
+          switch (os.branching()) {
+              case BRANCH_NONE:
+                  branch(*this, cells, INT_VAR_NONE(), value);
+                  break;
+              case BRANCH_AFC:
+                  branch(*this, cells, INT_VAR_AFC_MAX(os.decay()), value);
+                  break;
+              case BRANCH_ACTIVITY:
+                  branch(*this, cells, INT_VAR_ACTIVITY_MAX(os.decay()), value);
+                  break;
+          }
           branch(*this, noOfLives, INT_VAL_SPLIT_MAX());
+          Census::mark(census, *this, NULL);
     }
     
-    BoolVarArgs getNeighbours(int col, int row){
-        BoolVarArgs neighbours;
-        Matrix<BoolVarArgs> matrix(cells, board_size, board_size);
-        neighbours << matrix(col-1,row-1)<< matrix(col,row-1)<< matrix(col+1,row-1)// above neighbours
-                << matrix(col-1,row)<< matrix(col+1,row) // side neighbours
-                << matrix(col-1,row+1) << matrix(col,row+1)<< matrix(col+1,row+1);//below neighbours
-        return neighbours;
+    /*
+     * Maximum number of live cells in a w x h block (columns x rows) of a still life,
+     * where left, right, top and bottom tell which sides of the block lie on the dead
+     * border. Computed offline by exhaustive search over the block and two cells of
+     * context around it, checking the still life rules of every cell whose whole
+     * neighbourhood is known; so the bounds hold for every still life.
+     */
+    static int blockBound(int w, int h, bool left, bool right, bool top, bool bottom) {
+        static const int bound[3][3][16] = {
+            {
+                {1,1,1,0,1,1,1,0,1,1,1,0,0,0,0,0}, // 1x1
+                {2,2,2,0,2,2,2,0,2,2,2,0,2,2,2,0}, // 1x2
+                {3,2,2,0,3,2,2,0,3,2,2,0,2,2,2,0} // 1x3
+            },
+            {
+                {2,2,2,2,2,2,2,2,2,2,2,2,0,0,0,0}, // 2x1
+                {4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4}, // 2x2
+                {4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4} // 2x3
+            },
+            {
+                {3,3,3,2,2,2,2,2,2,2,2,2,0,0,0,0}, // 3x1
+                {4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4}, // 3x2
+                {6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6} // 3x3
+            }
+        };
+        return bound[w-1][h-1][left | right << 1 | top << 2 | bottom << 3];
     }
-
+    
+    /*
+     * Known optimum for board size n from the table in file (lines "n optimum",
+     * # starts a comment), -1 if the file or the entry is missing.
+     */
+    static int knownOptimum(const char* file, int n) {
+        if (file == NULL)
+            return -1;
+        std::ifstream in(file);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#')
+                continue;
+            std::istringstream l(line);
+            int size, optimum;
+            if ((l >> size >> optimum) && size == n)
+                return optimum;
+        }
+        return -1;
+    }
+    
     MaximumDensityStillLife(bool share, MaximumDensityStillLife& mdsl) : Script(share,mdsl) {
         cells.update(*this, share, mdsl.cells);
         sliceOfMDP.update(*this, share, mdsl.sliceOfMDP);
         noOfLives.update(*this, share, mdsl.noOfLives);
+        phase.update(*this, share, mdsl.phase);
     }
     
     // search for a best solution
@@ -105,14 +275,129 @@ public:
     }
     
     virtual Space* copy(bool share) {
+        PerfCounters::Scope perf(PerfCounters::PH_COPY);
         return new MaximumDensityStillLife(share,*this);
     }
     
+    // Clones come from the pooled allocator when -pool is given
+    static void* operator new(size_t s) {
+        return PoolAllocator::alloc(s);
+    }
+    static void operator delete(void* p) {
+        PoolAllocator::free(p);
+    }
+    
+    // Kind of brancher making the current choice, for the search histograms
+    const char* brancher(void) const {
+        for (int i = 0; i < cells.size(); i++)
+            if (!cells[i].assigned())
+                return "cells";
+        return "noOfLives";
+    }
+    
+    // Number of live cells in a solution
+    int lives(void) const {
+        return noOfLives.val();
+    }
+    // Never accept fewer lives than the best solution any model has found
+    void shareIncumbent(const std::atomic<int>& best) {
+        sharedBound(*this, noOfLives, best);
+    }
+    
+    // Cells for shaving (see shave.cpp)
+    int shaveSize(void) const {
+        return cells.size();
+    }
+    int shaveMin(int k) const {
+        return cells[k].min();
+    }
+    int shaveMax(int k) const {
+        return cells[k].max();
+    }
+    void shaveRel(int k, IntRelType r, int v) {
+        rel(*this, cells[k], r, v);
+    }
+    
+    /*
+     * Phase saving: a cell takes the value it was last assigned (on any branch, or
+     * in the hints), alive if it has none yet. Both alternatives assign the cell, so
+     * both save its value. Recomputation would commit again with stale values, so
+     * search with phase saving copies every node (c_d = 1, see main and portfolio).
+     */
+    static int phaseCell(const Space& home, BoolVar x, int i) {
+        int v = static_cast<const MaximumDensityStillLife&>(home).phase[i];
+        return (v >= 0) ? v : 1;
+    }
+    
+    static void commitCell(Space& home, unsigned int a, BoolVar x, int i, int n) {
+        MaximumDensityStillLife& mdsl = static_cast<MaximumDensityStillLife&>(home);
+        if (a == 0) {
+            rel(home, x, IRT_EQ, n);
+            mdsl.phase[i] = n;
+        } else {
+            rel(home, x, IRT_NQ, n);
+            mdsl.phase[i] = 1 - n;
+        }
+    }
+    
+    /*
+     * Hints: a pattern of this or another board size as lines "col row value" in
+     * coordinates without the border. Cells on this board take them as their phase.
+     */
+    void loadHints(const char* file) {
+        std::ifstream in(file);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#')
+                continue;
+            std::istringstream l(line);
+            int col, row, v;
+            if (!(l >> col >> row >> v))
+                continue;
+            if ((col >= 0) && (col < board_size-4) && (row >= 0) && (row < board_size-4))
+                phase[(col+2) + (row+2)*board_size] = (v != 0) ? 1 : 0;
+        }
+    }
+    
+    // Write a solution given by its snapshot as hints
+    static void saveHints(const char* file, const std::vector<int>& v) {
+        std::ofstream out(file);
+        int boardSize = sqrt(v.size() - 1);
+        out << "# still life with " << v[0] << " lives: col row value" << std::endl;
+        for (int r = 2; r < boardSize-2; r++)
+            for (int c = 2; c < boardSize-2; c++)
+                out << c-2 << " " << r-2 << " " << v[1 + c + r*boardSize] << std::endl;
+    }
+    
+    // Largest number of lives propagation leaves possible
+    int maxLives(void) const {
+        return noOfLives.max();
+    }
+    
+    // Whether the cell in column col and row row of the pattern (without border) lives
+    bool alive(int col, int row) const {
+        return cells[(col+2) + (row+2)*board_size].val() == 1;
+    }
+    
+    // Values of a solution for OutputWriter: number of lives, then the cells
+    void snapshot(std::vector<int>& v) const {
+        v.clear();
+        v.push_back(noOfLives.val());
+        for (int i = 0; i < cells.size(); i++)
+            v.push_back(cells[i].val());
+    }
+
     virtual void print(std::ostream& p) const {
+        std::vector<int> v;
+        snapshot(v);
+        print(p, v);
+    }
+
+    // Print a solution given by its snapshot
+    static void print(std::ostream& p, const std::vector<int>& v) {
         
-        std::cout << "Number of lives: " << noOfLives << "\n";
-        int boardSize=sqrt(cells.size());
-        Matrix<BoolVarArgs> matrix(cells, boardSize, boardSize);
+        p << "Number of lives: " << v[0] << "\n";
+        int boardSize=sqrt(v.size() - 1);
         
         for (int c = 2; c < boardSize-2; c++) {
             for (int l = 2; l < boardSize-2; l++){
@@ -120,7 +405,7 @@ public:
             }
             p << std::endl;
             for (int r = 2; r < boardSize-2; r++) {
-                p << matrix(c,r) << "| ";
+                p << v[1 + c + r*boardSize] << "| ";
             }
             p << std::endl;
         }
@@ -129,29 +414,292 @@ public:
 };
 
 
+#ifndef A4_LIBRARY
+/*
+ * Print a solution with the statistics of the search that found it.
+ */
+static void printSolution(std::ostream& os, const OutputSnapshot& snap) {
+   MaximumDensityStillLife::print(os, snap.values);
+   os << std::endl;
+   os<<"depth: "<<snap.stat.depth<<std::endl;
+   os<<"node: "<<snap.stat.node<<std::endl;
+   os<<"propagation: "<<snap.stat.propagate<<std::endl;
+   os<<"failures: "<<snap.stat.fail<<std::endl;
+   os<<"Memory: "<<snap.stat.memory<<std::endl<<std::endl;
+   os<<"///////////////////////"<<std::endl;
+}
+
+/*
+ * Print every improving solution of engine bab with its statistics, through writer
+ * if there is one. The writer may drop solutions when it falls behind, but never the
+ * last one (see OutputWriter::push()). Returns the snapshot of the best solution, empty if there is none.
+ */
+template<class Engine>
+static std::vector<int> bestSolutions(Engine& bab, SearchMonitor& monitor, OutputWriter* writer) {
+   std::vector<int> best;
+   for (;;) {
+       MaximumDensityStillLife* q;
+       {
+           PerfCounters::Scope search(PerfCounters::PH_SEARCH);
+           q = bab.next();
+       }
+       if (q == NULL)
+           break;
+       monitor.primal(q->lives());
+       OutputSnapshot snap;
+       q->snapshot(snap.values);
+       snap.stat = bab.statistics();
+       best = snap.values;
+       delete q;
+       if (writer != NULL) {
+           (void) writer->push(snap);
+       } else {
+           PerfCounters::Scope print(PerfCounters::PH_PRINT);
+           printSolution(std::cout, snap);
+       }
+   }
+   if (writer != NULL)
+       writer->close();
+   return best;
+}
+
+/*
+ * Run the linear and the extensional model at the same time, one BAB each on its own
+ * thread. Both see the best number of lives found by either (see SharedBound), the
+ * first to finish has proven optimality and stops the other. The monitor sees both
+ * searches (see PortfolioStop) and may stop them too, at the gap limit. Improving
+ * solutions are printed and returned as in bestSolutions.
+ */
+static std::vector<int> portfolio(const SolverOptions& so, SearchMonitor& monitor, OutputWriter* writer) {
+   static const int models[] = {
+       MaximumDensityStillLife::MODEL_LINEAR, MaximumDensityStillLife::MODEL_EXTENSIONAL
+   };
+   static const char* names[] = {"linear", "extensional"};
+   const int n = 2;
+   std::atomic<int> incumbent(INT_MIN);
+   std::atomic<int> winner(-1);
+   std::mutex m;
+   std::vector<int> best;
+   std::vector<Search::Statistics> stat(n), seen(n);
+   std::vector<std::thread> w;
+   for (int k = 0; k < n; k++)
+       w.push_back(std::thread([&, k] {
+           // Built on the thread that searches it, so nothing is shared between models
+           MaximumDensityStillLife* root = new MaximumDensityStillLife(so, models[k]);
+           if (so.hints_in() != NULL)
+               root->loadHints(so.hints_in());
+           root->shareIncumbent(incumbent);
+           PortfolioStop stop(winner, &monitor, &m, &seen, k);
+           Search::Options o;
+           o.stop = &stop;
+           if (so.phase())
+               o.c_d = 1;
+           BAB<MaximumDensityStillLife> bab(root, o);
+           delete root;
+           while (MaximumDensityStillLife* q = bab.next()) {
+               std::lock_guard<std::mutex> l(m);
+               if (q->lives() > incumbent.load()) {
+                   incumbent.store(q->lives());
+                   monitor.primal(q->lives());
+                   OutputSnapshot snap;
+                   q->snapshot(snap.values);
+                   snap.stat = bab.statistics();
+                   best = snap.values;
+                   if (writer != NULL) {
+                       (void) writer->push(snap);
+                   } else {
+                       std::cout<<"model: "<<names[k]<<std::endl;
+                       printSolution(std::cout, snap);
+                   }
+               }
+               delete q;
+           }
+           stat[k] = bab.statistics();
+           if (!bab.stopped()) {
+               int none = -1;
+               winner.compare_exchange_strong(none, k);
+           }
+       }));
+   for (int k = 0; k < n; k++)
+       w[k].join();
+   if (writer != NULL)
+       writer->close();
+   for (int k = 0; k < n; k++)
+       std::cout<<"model "<<names[k]<<": nodes: "<<stat[k].node
+                <<", failures: "<<stat[k].fail<<std::endl;
+   if (winner.load() >= 0)
+       std::cout<<"optimality proven by: "<<names[winner.load()]<<std::endl;
+   return best;
+}
+
 int main(int argc, char* argv[]) {
-  SizeOptions so("Maximum Density Still Life");
+  SolverOptions so("Maximum Density Still Life");
   so.size(8);
   so.solutions(0);
+  so.model(MaximumDensityStillLife::MODEL_LINEAR, "linear", "count neighbours with linear and reified constraints");
+  so.model(MaximumDensityStillLife::MODEL_EXTENSIONAL, "extensional", "one table constraint over each cell and its neighbours");
+  so.model(MaximumDensityStillLife::MODEL_LINEAR);
+  so.branching(MaximumDensityStillLife::BRANCH_NONE, "none", "branch on cells in memory order");
+  so.branching(MaximumDensityStillLife::BRANCH_AFC, "afc", "branch on the cell with largest accumulated failure count");
+  so.branching(MaximumDensityStillLife::BRANCH_ACTIVITY, "activity", "branch on the cell with largest activity");
+  so.branching(MaximumDensityStillLife::BRANCH_NONE);
+  so.decay(0.99);
+  // The driver bounds by the table next to it unless told otherwise (the library does not)
+  so.optima("still-life-optima.txt");
   so.parse(argc,argv);
+  if (so.speedup() && !so.deterministic()) {
+      std::cerr<<"-speedup needs -deterministic"<<std::endl;
+      return 1;
+  }
+  if (so.shave_subtrees() && !so.deterministic()) {
+      std::cerr<<"-shave-subtrees needs -deterministic (use -shave for the root)"<<std::endl;
+      return 1;
+  }
+  // The portfolio runs its own engines on models of its own
+  if (so.portfolio() && (so.deterministic() || so.histogram() || (so.census() > 0) ||
+                         (so.restart() != RM_NONE) || so.probe_only())) {
+      std::cerr<<"-portfolio cannot be combined with -deterministic, -histogram, -census, -restart or -probe-only"<<std::endl;
+      return 1;
+  }
   
 //  Script::run<MaximumDensityStillLife,BAB,SizeOptions>(so);
 //  return 0;
   
-   MaximumDensityStillLife* mdsl = new MaximumDensityStillLife(so);
+   PoolAllocator::enable(so.pool());
+   Support::Timer t;
+   t.start();
    
-   BAB<MaximumDensityStillLife> bab(mdsl);
-   delete mdsl;
-   while (MaximumDensityStillLife* q = bab.next()){
-       q->print(std::cout);
-       std::cout << std::endl;
-       std::cout<<"depth: "<<bab.statistics().depth<<std::endl;
-       std::cout<<"node: "<<bab.statistics().node<<std::endl;
-       std::cout<<"propagation: "<<bab.statistics().propagate<<std::endl;
-       std::cout<<"failures: "<<bab.statistics().fail<<std::endl;
-       std::cout<<"Memory: "<<bab.statistics().memory<<std::endl<<std::endl;
-       std::cout<<"///////////////////////"<<std::endl;
-       delete q;
+   // A wrong table makes the search infeasible or suboptimal, so say what is used
+   int known = MaximumDensityStillLife::knownOptimum(so.optima(), so.size());
+   if (known >= 0)
+       std::cout<<"known optimum from "<<so.optima()<<": "<<known
+                <<(so.verify() ? " (verified)" : " (upper bound)")<<std::endl;
+   
+   PerfCounters* perf = so.perf() ? new PerfCounters : NULL;
+   MaximumDensityStillLife* mdsl;
+   Census* census = (so.census() > 0) ? new Census : NULL;
+   Support::Timer build_time;
+   build_time.start();
+   {
+       PerfCounters::Scope build(PerfCounters::PH_BUILD);
+       mdsl = new MaximumDensityStillLife(so, census);
+   }
+   // The portfolio loads the hints into its own models
+   if ((so.hints_in() != NULL) && !so.portfolio())
+       mdsl->loadHints(so.hints_in());
+   std::cout<<"model build: "<<build_time.stop()<<" ms"<<std::endl;
+   (void) mdsl->status();
+   std::cout<<"root memory: "<<mdsl->allocated()<<" bytes"<<std::endl;
+   // The census samples the root after propagation, then every -census nodes
+   if ((census != NULL) && !mdsl->failed())
+       census->sample(*mdsl);
+   
+   /*
+    * The root only gives the portfolio its dual bound, it is never searched: neither
+    * shave nor probe it.
+    */
+   if (so.portfolio() && (so.shave() || (so.probes() > 0)))
+       std::cout<<"-portfolio: no root shaving or probing"<<std::endl;
+   
+   // Root shaving, before the estimate so that it sees the tighter domains
+   if (so.shave() && !so.portfolio()) {
+       Shaving<MaximumDensityStillLife>::Statistics shaving;
+       (void) Shaving<MaximumDensityStillLife>::shave(mdsl, so.workers(), shaving);
+       shaving.print(std::cout);
+   }
+   
+   // Probes ignore the bounds BAB adds, so the estimate is an upper bound
+   TreeEstimate estimate;
+   if ((so.probes() > 0) && !so.portfolio()) {
+       estimate = TreeEstimate::probe(mdsl, so.probes(), 5000, so.probe_seed());
+       estimate.print(std::cout);
+   }
+   if (so.probe_only()) {
+       delete mdsl;
+       delete census;
+       delete perf;
+       return 0;
+   }
+   
+   /*
+    * Primal bound is the incumbent, dual bound what root propagation leaves for the
+    * number of lives; BAB proves no better dual until it finishes.
+    */
+   SearchMonitor monitor(std::cerr, estimate.nodes, so.progress());
+   monitor.objective(true, so.gap_limit());
+   if (mdsl->status() != SS_FAILED)
+       monitor.dual(mdsl->maxLives());
+   Search::Options o;
+   o.stop = &monitor;
+   // Phases are saved on commit, which recomputation would replay: copy every node
+   if (so.phase())
+       o.c_d = 1;
+   Heartbeat* heartbeat = (so.heartbeat() != NULL) ?
+       new Heartbeat(monitor, so.heartbeat(), so.heartbeat_interval()) : NULL;
+   OutputWriter* writer = so.async_output() ?
+       new OutputWriter(std::cout, printSolution) : NULL;
+   
+   std::vector<int> best;
+   if (so.portfolio()) {
+       delete mdsl;
+       best = portfolio(so, monitor, writer);
+   } else if (so.histogram() || (census != NULL)) {
+       HistogramEngine<MaximumDensityStillLife,true> bab(mdsl, o);
+       bab.sample(census, so.census());
+       bab.monitor(&monitor);
+       delete mdsl;
+       best = bestSolutions(bab, monitor, writer);
+       bab.histogram().print(std::cout);
+       if (census != NULL)
+           census->print(std::cout);
+   } else if (so.deterministic()) {
+       DeterministicBAB<MaximumDensityStillLife> bab(mdsl, so.workers(), so.split_depth(), so.numa(), o);
+       bab.shave(so.shave_subtrees());
+       std::cout<<"subtrees: "<<bab.subtrees()<<std::endl;
+       best = bestSolutions(bab, monitor, writer);
+       bab.print(std::cout);
+       if (so.speedup()) {
+           // The same search on one worker, after ours so that they do not compete
+           DeterministicBAB<MaximumDensityStillLife> b(mdsl, 1, so.split_depth());
+           b.shave(so.shave_subtrees());
+           while (MaximumDensityStillLife* s = b.next())
+               delete s;
+           bab.speedup(std::cout, b);
+       }
+       delete mdsl;
+   } else if (so.restart() != RM_NONE) {
+       // Restart-based BAB, the cutoff sequence comes from -restart and -restart-scale
+       o.cutoff = cutoff(so);
+       RBS<BAB,MaximumDensityStillLife> bab(mdsl, o);
+       delete mdsl;
+       best = bestSolutions(bab, monitor, writer);
+       std::cout<<"restarts: "<<bab.statistics().restart<<std::endl;
+   } else {
+       BAB<MaximumDensityStillLife> bab(mdsl, o);
+       delete mdsl;
+       best = bestSolutions(bab, monitor, writer);
+   }
+   // Search ran to the end unless the gap limit stopped it: the incumbent is optimal
+   if (monitor.primal_known() && !monitor.gap_stopped())
+       monitor.dual(monitor.primal());
+   delete heartbeat;
+   if ((so.hints_out() != NULL) && !best.empty())
+       MaximumDensityStillLife::saveHints(so.hints_out(), best);
+   monitor.bounds(std::cout);
+   std::cout<<std::endl;
+   if (writer != NULL) {
+       std::cout<<"solutions written: "<<writer->written()
+                <<", dropped: "<<writer->dropped()<<std::endl;
+       delete writer;
+   }
+   delete census;
+   std::cout<<"runtime: "<<t.stop()<<" ms"<<std::endl;
+   if (so.pool())
+       PoolAllocator::print(std::cout);
+   if (perf != NULL) {
+       perf->print(std::cout);
+       delete perf;
    }
    return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -5,9 +5,24 @@
 #include <gecode/int.hh>
 #include <gecode/minimodel.hh>
 #include <cmath>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
 #include "no-overlap.cpp"
 #include "interval.cpp"
+#include "pool-alloc.cpp"
+#include "solver-options.cpp"
+#include "estimate.cpp"
+#include "search-monitor.cpp"
+#include "heartbeat.cpp"
+#include "nooverlap-check.cpp"
+#include "search-histogram.cpp"
+#include "deterministic.cpp"
+#include "output-writer.cpp"
+#include "census.cpp"
+#include "shave.cpp"
 
 
 
@@ -24,21 +39,49 @@ public:
   IntVarArray X;
   IntVarArray Y;
   
+  /*
+   * monitor that learns the lower bounds proven on s, NULL for none
+   */
+  SearchMonitor* bounds;
+  
+  /*
+   * phase saving: the value each coordinate (X, then Y) was last assigned on any
+   * branch, -1 for none yet; shared by the clones of a search, so that it survives
+   * failures and restarts. value_branching is the value selection to fall back to.
+   */
+  SharedArray<int> phase;
+  int value_branching;
+  
   enum {
       MODEL_REIFY, MODEL_NOOVERLAP
   };
+  
+  enum {
+      BRANCH_VALUE_ORDER, BRANCH_CONTACT
+  };
+  
+  // Share of a square's size the interval branching narrows its coordinates to
+  static constexpr double INTERVAL_SHARE = 0.7;
 
-  SquarePacking(const SizeOptions& so) : 
+  SquarePacking(const SolverOptions& so, Census* census = NULL) : 
   
   X(*this, so.size()-1, 0, ((so.size()*(so.size()+1))/2)), 
   Y(*this, so.size()-1, 0, ((so.size()*(so.size()+1))/2)),
           
   // problem decomposition according to the given formula in section 2.1
-  s(*this, ceil(sqrt((so.size()*(so.size()+1)*(2*so.size()+1))/6)), ((so.size()*(so.size()+1))/2))
+  s(*this, ceil(sqrt((so.size()*(so.size()+1)*(2*so.size()+1))/6)), ((so.size()*(so.size()+1))/2)),
+  bounds(NULL), phase(2*(so.size()-1)), value_branching(so.branching())
   {
+    for (int i = 0; i < phase.size(); i++)
+        phase[i] = -1;
 
     int no_of_squares = so.size();
     int S1, S2, si;
+    
+    Census::variables(census, "s", 1);
+    Census::variables(census, "X", X.size());
+    Census::variables(census, "Y", Y.size());
+    Census::mark(census, *this, so.model() == MODEL_REIFY ? "part 2: reified disjunctions" : "part 2: NoOverlap");
       
       switch (so.model()){
           
@@ -52,7 +95,6 @@ public:
            */
           case MODEL_REIFY:
           {
-              std::cout<<"Using reified constraints : "<<std::endl;
               for(int k = 0; k < no_of_squares-1; k++)
               {
                   for(int l = 0; l < no_of_squares-1; l++)
@@ -76,29 +118,35 @@ public:
           }
           
           case MODEL_NOOVERLAP:{
-              std::cout<<"Using the No-overlap propagator: "<<std::endl;
               IntArgs square_size(no_of_squares-1);
               for (int i = 0; i < no_of_squares-1; i++){
                   square_size[i] = size(no_of_squares, i);
               }
-              NoOverlap(*this, X, square_size, Y, square_size);
+              // Also keeps the squares inside s, see below
+              NoOverlap(*this, X, square_size, Y, square_size, s);
               break;
           } 
       }
 
       /*
          * Further constrain on coordinates Y and X
+         * (the NoOverlap model does this inside the propagator)
          */
-    for(int i = 0; i < no_of_squares-1; i++)
-      {
-        si = size(no_of_squares,i);
-        rel(*this, ((X[i] + si) <= s));
-        rel(*this, ((Y[i] + si) <= s));
-      }
+    Census::mark(census, *this, "container linears");
+    if (so.model() == MODEL_REIFY) {
+      for(int i = 0; i < no_of_squares-1; i++)
+        {
+          si = size(no_of_squares,i);
+          rel(*this, ((X[i] + si) <= s));
+          rel(*this, ((Y[i] + si) <= s));
+        }
+    }
 
     /*
      * part 3: at each row and column sum of the sizes of the squares occupying space <= s.
      */
+    Census::variables(census, "part 3 Booleans", 2*s.max()*(no_of_squares-1));
+    Census::mark(census, *this, "part 3: row and column sums");
 
     for(int cr = 0; cr < s.max(); cr++) 
       {
@@ -130,6 +178,7 @@ public:
 	 * since we do not have negative interval, it is enough to say:
 	 * X coordination of bigest square should be less than (size - n)/2
      */
+    Census::mark(census, *this, "part 4: symmetry removal");
  
     rel(*this, X[0] <= (s-no_of_squares)/2 && Y[0] <= X[0]);          
          
@@ -138,6 +187,7 @@ public:
      * part 4: additional constraints.
      * c)  initial domain reduction
      */
+    Census::mark(census, *this, "part 4: initial domain reduction");
 
     for(int l = 0; l < no_of_squares-1; l++)
       {
@@ -204,57 +254,104 @@ public:
      * (a)Branch on s first. Also we started with smallest possible value for enclosing square,
      * since we need to find out minimum value for enclosing square. 
      */
-    branch(*this, s, INT_VAL_MIN()); 
+    Census::mark(census, *this, "branching");
+    branch(*this, s, INT_VAL(&minS, &commitS)); 
     /* 
      * (b) first assign all x-coordinates, then all y-coordinates.
      * (c) To try larger squares first we used INT_VAR_NONE() since the first unassigned variable is actually the largest one so the assignment continues in descending order.
      * (d) To place squares from left to right we must start with minimum possible value for x-coordinates, so we used  INT_VAL_MIN
      *     and to place top to bottom we must start with maximum possible value for y-coordinates, so we used INT_VAL_MAX
      */
-    interval(*this, X, square_size, 0.7);
-    branch(*this, X, INT_VAR_NONE(), INT_VAL_MIN());
-    interval(*this, Y, square_size, 0.7);
-    branch(*this, Y, INT_VAR_NONE(), INT_VAL_MAX());
+    interval(*this, X, square_size, INTERVAL_SHARE);
+    if (so.phase()) {
+        /*
+         * (f) Either value selection, but a coordinate takes its saved phase first
+         *     (see phaseValue()).
+         */
+        branch(*this, X, INT_VAR_NONE(), INT_VAL(&phaseX, &commitX));
+        interval(*this, Y, square_size, INTERVAL_SHARE);
+        branch(*this, Y, INT_VAR_NONE(), INT_VAL(&phaseY, &commitY));
+    } else switch (so.branching()) {
+        case BRANCH_VALUE_ORDER:
+            branch(*this, X, INT_VAR_NONE(), INT_VAL_MIN());
+            interval(*this, Y, square_size, INTERVAL_SHARE);
+            branch(*this, Y, INT_VAR_NONE(), INT_VAL_MAX());
+            break;
+        /*
+         * (e) Same variable order, but each coordinate takes a value at which the square
+         *     touches the container border or an already placed square (see contact()).
+         */
+        case BRANCH_CONTACT:
+            branch(*this, X, INT_VAR_NONE(), INT_VAL(&contactX));
+            interval(*this, Y, square_size, INTERVAL_SHARE);
+            branch(*this, Y, INT_VAR_NONE(), INT_VAL(&contactY));
+            break;
+    }
+    Census::mark(census, *this, NULL);
   }
 
-  SquarePacking(bool share, SquarePacking& sp) : Script(share,sp) {
+  SquarePacking(bool share, SquarePacking& sp) : Script(share,sp), bounds(sp.bounds),
+    value_branching(sp.value_branching) {
     s.update(*this, share, sp.s);
     Y.update(*this, share, sp.Y);
     X.update(*this, share, sp.X);
+    phase.update(*this, share, sp.phase);
     
     
   }
 
   virtual Space* copy(bool share) {
+    PerfCounters::Scope perf(PerfCounters::PH_COPY);
     return new SquarePacking(share,*this);
   }
+  
+  // Clones come from the pooled allocator when -pool is given
+  static void* operator new(size_t s) {
+    return PoolAllocator::alloc(s);
+  }
+  static void operator delete(void* p) {
+    PoolAllocator::free(p);
+  }
+
+  // Values of a solution for OutputWriter: s, then X, then Y
+  void snapshot(std::vector<int>& v) const {
+      v.clear();
+      v.push_back(s.val());
+      for (int i = 0; i < X.size(); i++)
+          v.push_back(X[i].val());
+      for (int i = 0; i < Y.size(); i++)
+          v.push_back(Y[i].val());
+  }
 
   virtual void print(std::ostream& p) const
   {
-         int ps = s.val();
-      p << "The size of packing square = " << s <<std::endl;
+      std::vector<int> v;
+      snapshot(v);
+      print(p, v);
+  }
+
+  // Print a solution given by its snapshot
+  static void print(std::ostream& p, const std::vector<int>& v)
+  {
+      int ps = v[0];
+      int m = static_cast<int>(v.size() - 1) / 2;
+      const int* x = &v[1];
+      const int* y = &v[1 + m];
+      p << "The size of packing square = " << ps <<std::endl;
       p << "Coordinates (starts from largest square to 2): " <<std::endl;  
-      p << "X- coordinates :" << X << std::endl;
-      p << "Y- coordinates:" << Y << std::endl;
+      p << "X- coordinates :" << coordinates(x, m) << std::endl;
+      p << "Y- coordinates:" << coordinates(y, m) << std::endl;
 
-    char ** matrix;
+    std::vector<std::vector<char> > matrix(ps, std::vector<char>(ps, '#'));
+    for (int w = 0; w < m; w++) {
 
-    matrix = new char * [ps];
-    for (int i = 0; i < ps; i++) {
-      matrix[i] = new char[ps];
-      for(int j = 0; j < ps; j++) {
-        matrix[i][j] = '#';
-      }
-    }
-    for (int w = 0; w < X.size(); w++) {
-
-      int xcord = X[w].val() + size(X.size()+1, w);
-      int ycord = Y[w].val() + size(X.size()+1, w);
+      int xcord = x[w] + size(m+1, w);
+      int ycord = y[w] + size(m+1, w);
 
-      for (int i = Y[w].val(); i < ycord; i++){
-        for (int j = X[w].val(); j < xcord; j++){
-          if(size(X.size()+1, w) > 9) matrix[i][j] = 'A' + (char)(size(X.size()+1, w) - 10);
-          else matrix[i][j] = '0' + (char)size(X.size()+1, w);
+      for (int i = y[w]; i < ycord; i++){
+        for (int j = x[w]; j < xcord; j++){
+          if(size(m+1, w) > 9) matrix[i][j] = 'A' + (char)(size(m+1, w) - 10);
+          else matrix[i][j] = '0' + (char)size(m+1, w);
 
         }
       }
@@ -269,6 +366,199 @@ public:
       
     }
   }
+
+  // Coordinates formatted like an assigned IntVarArray
+  static std::string coordinates(const int* c, int m)
+  {
+      std::ostringstream o;
+      o << "{";
+      for (int i = 0; i < m; i++)
+          o << (i > 0 ? ", " : "") << c[i];
+      o << "}";
+      return o.str();
+  }
+  
+  /*
+   * Contact value selection. Among the values left for coordinate p[i] of square i, pick
+   * one at which the square touches the container border or a square j that is already
+   * placed in this dimension and whose extent in the other dimension (q) can still meet i.
+   * x-coordinates take the smallest such value (left to right), y-coordinates the largest
+   * one (top to bottom). Without any contact value we fall back to plain min/max.
+   */
+  int contact(const IntVarArray& p, const IntVarArray& q, int i, bool largest) const {
+      int n = p.size() + 1;
+      int si = size(n, i);
+      int best = largest ? p[i].max() : p[i].min();
+      bool found = false;
+      for (IntVarValues v(p[i]); v(); ++v) {
+          bool touches = (v.val() == 0) || (v.val() + si == s.max());
+          for (int j = 0; !touches && j < p.size(); j++) {
+              if (j == i || !p[j].assigned())
+                  continue;
+              int sj = size(n, j);
+              // no contact possible if the squares can never share a row (column)
+              if (q[j].min() >= q[i].max() + si || q[j].max() + sj <= q[i].min())
+                  continue;
+              touches = (v.val() == p[j].val() + sj) || (v.val() + si == p[j].val());
+          }
+          if (touches && (!found || (largest ? v.val() > best : v.val() < best))) {
+              best = v.val();
+              found = true;
+          }
+      }
+      return best;
+  }
+  
+  /*
+   * Branching on s tries its values upward, so taking the second alternative (s != n)
+   * means the whole subtree for s = n has failed: n+1 is a proven lower bound. Only
+   * meaningful for sequential depth-first search, see monitor().
+   */
+  static int minS(const Space&, IntVar x, int) {
+      return x.min();
+  }
+  
+  static void commitS(Space& home, unsigned int a, IntVar x, int, int n) {
+      if (a == 0) {
+          rel(home, x, IRT_EQ, n);
+      } else {
+          rel(home, x, IRT_NQ, n);
+          SquarePacking& sp = static_cast<SquarePacking&>(home);
+          if (sp.bounds != NULL)
+              sp.bounds->dual(n + 1);
+      }
+  }
+  
+  // Coordinates for shaving (see shave.cpp): X, then Y
+  int shaveSize(void) const {
+      return X.size() + Y.size();
+  }
+  const IntVar& shaveVar(int k) const {
+      return (k < X.size()) ? X[k] : Y[k - X.size()];
+  }
+  int shaveMin(int k) const {
+      return shaveVar(k).min();
+  }
+  int shaveMax(int k) const {
+      return shaveVar(k).max();
+  }
+  void shaveRel(int k, IntRelType r, int v) {
+      rel(*this, shaveVar(k), r, v);
+  }
+  
+  // Report proven lower bounds on s to m
+  void monitor(SearchMonitor* m) {
+      bounds = m;
+  }
+  
+  static int contactX(const Space& home, IntVar x, int i) {
+      const SquarePacking& sp = static_cast<const SquarePacking&>(home);
+      return sp.contact(sp.X, sp.Y, i, false);
+  }
+  
+  static int contactY(const Space& home, IntVar y, int i) {
+      const SquarePacking& sp = static_cast<const SquarePacking&>(home);
+      return sp.contact(sp.Y, sp.X, i, true);
+  }
+  
+  /*
+   * Phase saving. A coordinate takes the value it was last assigned (on any branch,
+   * or in the hints) if that is still possible, otherwise the value of the normal
+   * value selection. Every assignment the search makes is saved when it is committed;
+   * recomputation would commit again with stale values, so search with phase saving
+   * copies every node (c_d = 1, see main).
+   */
+  int phaseValue(const IntVarArray& p, const IntVarArray& q, int i, int offset,
+                 bool largest) const {
+      int v = phase[offset + i];
+      if ((v >= 0) && p[i].in(v))
+          return v;
+      if (value_branching == BRANCH_CONTACT)
+          return contact(p, q, i, largest);
+      return largest ? p[i].max() : p[i].min();
+  }
+  
+  static int phaseX(const Space& home, IntVar x, int i) {
+      const SquarePacking& sp = static_cast<const SquarePacking&>(home);
+      return sp.phaseValue(sp.X, sp.Y, i, 0, false);
+  }
+  
+  static int phaseY(const Space& home, IntVar y, int i) {
+      const SquarePacking& sp = static_cast<const SquarePacking&>(home);
+      return sp.phaseValue(sp.Y, sp.X, i, sp.X.size(), true);
+  }
+  
+  static void commitPhase(Space& home, unsigned int a, IntVar x, int i, int n) {
+      if (a == 0) {
+          rel(home, x, IRT_EQ, n);
+          static_cast<SquarePacking&>(home).phase[i] = n;
+      } else {
+          rel(home, x, IRT_NQ, n);
+      }
+  }
+  
+  static void commitX(Space& home, unsigned int a, IntVar x, int i, int n) {
+      commitPhase(home, a, x, i, n);
+  }
+  
+  static void commitY(Space& home, unsigned int a, IntVar y, int i, int n) {
+      commitPhase(home, a, y, static_cast<SquarePacking&>(home).X.size() + i, n);
+  }
+  
+  /*
+   * Hints: a solution of this or another instance as lines "size x y", one per
+   * square. Squares of the same size take the saved coordinates as their phase.
+   */
+  void loadHints(const char* file) {
+      std::ifstream in(file);
+      std::string line;
+      while (std::getline(in, line)) {
+          if (line.empty() || line[0] == '#')
+              continue;
+          std::istringstream l(line);
+          int si, hx, hy;
+          if (!(l >> si >> hx >> hy))
+              continue;
+          int i = X.size() + 1 - si;
+          if ((i >= 0) && (i < X.size())) {
+              phase[i] = hx;
+              phase[X.size() + i] = hy;
+          }
+      }
+  }
+  
+  // Write a solution given by its snapshot as hints
+  static void saveHints(const char* file, const std::vector<int>& v) {
+      std::ofstream out(file);
+      int m = static_cast<int>(v.size() - 1) / 2;
+      out << "# square packing of size " << m+1 << ": size x y" << std::endl;
+      for (int i = 0; i < m; i++)
+          out << size(m+1, i) << " " << v[1 + i] << " " << v[1 + m + i] << std::endl;
+  }
+  
+  // Whether the interval branching on coordinates p has squares left to split
+  bool intervalPending(const IntVarArray& p) const {
+      for (int i = 0; i < p.size(); i++) {
+          int si = size(p.size()+1, i);
+          if (intervalSplits(p[i], si, INTERVAL_SHARE))
+              return true;
+      }
+      return false;
+  }
+  
+  // Kind of brancher making the current choice, for the search histograms
+  const char* brancher(void) const {
+      if (!s.assigned())
+          return "s";
+      if (intervalPending(X))
+          return "interval";
+      for (int i = 0; i < X.size(); i++)
+          if (!X[i].assigned())
+              return "value";
+      if (intervalPending(Y))
+          return "interval";
+      return "value";
+  }
   
   /*
    * Static member function size that returns the size of the square with number i.
@@ -279,11 +569,19 @@ public:
   }
 };
 
+#ifndef A4_LIBRARY
+static void printPacking(std::ostream& os, const OutputSnapshot& snap) {
+  SquarePacking::print(os, snap.values);
+}
+
 int main(int argc, char* argv[]) {
-  SizeOptions so("Solution for square packing ");
+  SolverOptions so("Solution for square packing ");
   so.model(SquarePacking::MODEL_REIFY,"reify", "use reified constraints" );
   so.model(SquarePacking::MODEL_NOOVERLAP,"NoOverlap", "use our own no-overlap propagator" );
   so.model(SquarePacking::MODEL_NOOVERLAP);
+  so.branching(SquarePacking::BRANCH_VALUE_ORDER, "order", "place squares by plain value order");
+  so.branching(SquarePacking::BRANCH_CONTACT, "contact", "prefer values touching the border or placed squares");
+  so.branching(SquarePacking::BRANCH_VALUE_ORDER);
   so.size(24);
 //  so.iterations(50);
 //  so.samples(100);
@@ -300,22 +598,176 @@ int main(int argc, char* argv[]) {
 //  
 //  
   
-  SquarePacking* sp = new SquarePacking(so);
+  /*
+   * s is tried upward, so the first solution is already optimal: there is no primal
+   * bound before search ends and a gap limit could never stop it.
+   */
+  if (so.speedup() && !so.deterministic()) {
+      std::cerr<<"-speedup needs -deterministic"<<std::endl;
+      return 1;
+  }
+  if (so.shave_subtrees() && !so.deterministic()) {
+      std::cerr<<"-shave-subtrees needs -deterministic (use -shave for the root)"<<std::endl;
+      return 1;
+  }
+  if (so.gap_limit() >= 0.0) {
+      std::cerr<<"-gap-limit has no effect for square packing (the first solution is optimal)"<<std::endl;
+      return 1;
+  }
+  
+  // Only check the propagator and the brancher on random instances
+  if (so.check() > 0)
+      return NoOverlapCheck::run(so.check(), so.check_seed(), std::cout) ? 0 : 1;
+  
+  if (so.model() == SquarePacking::MODEL_REIFY)
+      std::cout<<"Using reified constraints : "<<std::endl;
+  else
+      std::cout<<"Using the No-overlap propagator: "<<std::endl;
+  
+  PoolAllocator::enable(so.pool());
+  Support::Timer t;
+  t.start();
+  
+  PerfCounters* perf = so.perf() ? new PerfCounters : NULL;
+  SquarePacking* sp;
+  Census* census = (so.census() > 0) ? new Census : NULL;
+  {
+      PerfCounters::Scope build(PerfCounters::PH_BUILD);
+      sp = new SquarePacking(so, census);
+  }
+  if (so.hints_in() != NULL)
+      sp->loadHints(so.hints_in());
+  // The census samples the root after propagation, then every -census nodes
+  if ((census != NULL) && (sp->status() != SS_FAILED))
+      census->sample(*sp);
+  
+  // Root shaving, before the estimate so that it sees the tighter domains
+  if (so.shave()) {
+      Shaving<SquarePacking>::Statistics shaving;
+      (void) Shaving<SquarePacking>::shave(sp, so.workers(), shaving);
+      shaving.print(std::cout);
+  }
+  
+  /*
+   * Estimate the size of the tree first (at most 5 seconds of probing), 
+   * the estimate drives the progress reports below.
+   */
+  TreeEstimate estimate;
+  if (so.probes() > 0) {
+      estimate = TreeEstimate::probe(sp, so.probes(), 5000, so.probe_seed());
+      estimate.print(std::cout);
+  }
+  if (so.probe_only()) {
+      delete sp;
+      delete census;
+      delete perf;
+      return 0;
+  }
+  
+  /*
+   * The monitor keeps the bounds on s: the root propagation gives the first lower
+   * bound, the branching on s proves the next ones (sequential search only, the
+   * deterministic engine explores values of s out of order).
+   */
+  SearchMonitor monitor(std::cerr, estimate.nodes, so.progress());
+  monitor.objective(false);
+  if (sp->status() != SS_FAILED)
+      monitor.dual(sp->s.min());
+  if (!so.deterministic())
+      sp->monitor(&monitor);
+  Search::Options o;
+  o.stop = &monitor;
+  // Phases are saved on commit, which recomputation would replay: copy every node
+  if (so.phase())
+      o.c_d = 1;
+  Heartbeat* heartbeat = (so.heartbeat() != NULL) ?
+      new Heartbeat(monitor, so.heartbeat(), so.heartbeat_interval()) : NULL;
 
-  DFS<SquarePacking> dfs(sp);
+  SquarePacking* q;
+  Search::Statistics stat;
+  SearchHistogram* histogram = NULL;
+  {
+      PerfCounters::Scope search(PerfCounters::PH_SEARCH);
+      if (so.histogram() || (census != NULL)) {
+          HistogramEngine<SquarePacking,false> e(sp, o);
+          e.sample(census, so.census());
+          e.monitor(&monitor);
+          q = e.next();
+          stat = e.statistics();
+          histogram = new SearchHistogram(e.histogram());
+      } else if (so.deterministic()) {
+          DeterministicDFS<SquarePacking> e(sp, so.workers(), so.split_depth(), so.numa(), o);
+          e.shave(so.shave_subtrees());
+          std::cout<<"subtrees: "<<e.subtrees()<<std::endl;
+          q = e.next();
+          stat = e.statistics();
+          e.print(std::cout);
+          if (so.speedup()) {
+              // The same search on one worker, after ours so that they do not compete
+              DeterministicDFS<SquarePacking> b(sp, 1, so.split_depth());
+              b.shave(so.shave_subtrees());
+              delete b.next();
+              e.speedup(std::cout, b);
+          }
+      } else {
+          DFS<SquarePacking> dfs(sp, o);
+          q = dfs.next();
+          stat = dfs.statistics();
+      }
+  }
   delete sp;
-  SquarePacking* q = dfs.next();
-  q->print(std::cout);
+  // No solution if a limit stopped the search first
+  if ((q != NULL) && (so.hints_out() != NULL)) {
+      std::vector<int> v;
+      q->snapshot(v);
+      SquarePacking::saveHints(so.hints_out(), v);
+  }
+  // The first solution is optimal: s goes upward
+  if (q != NULL) {
+      monitor.primal(q->s.val());
+      monitor.dual(q->s.val());
+  }
+  delete heartbeat;
+  if (q == NULL) {
+      std::cout<<"search stopped without a solution"<<std::endl;
+  } else if (so.async_output()) {
+      // The writer thread prints, its destructor waits for it
+      OutputWriter writer(std::cout, printPacking);
+      OutputSnapshot snap;
+      q->snapshot(snap.values);
+      snap.stat = stat;
+      writer.put(snap);
+  } else {
+      PerfCounters::Scope print(PerfCounters::PH_PRINT);
+      q->print(std::cout);
+  }
       std::cout << std::endl;
-      std::cout<<"depth: "<<dfs.statistics().depth<<std::endl;
-      std::cout<<"node: "<<dfs.statistics().node<<std::endl;
-      std::cout<<"propagation: "<<dfs.statistics().propagate<<std::endl;
-      std::cout<<"failures: "<<dfs.statistics().fail<<std::endl;
-      std::cout<<"Memory: "<<dfs.statistics().memory<<std::endl;
+      std::cout<<"depth: "<<stat.depth<<std::endl;
+      std::cout<<"node: "<<stat.node<<std::endl;
+      std::cout<<"propagation: "<<stat.propagate<<std::endl;
+      std::cout<<"failures: "<<stat.fail<<std::endl;
+      monitor.bounds(std::cout);
+      std::cout<<std::endl;
+      std::cout<<"Memory: "<<stat.memory<<std::endl;
+      if (histogram != NULL) {
+          histogram->print(std::cout);
+          delete histogram;
+      }
+      if (census != NULL) {
+          census->print(std::cout);
+          delete census;
+      }
+      std::cout<<"runtime: "<<t.stop()<<" ms"<<std::endl;
+      if (so.pool())
+          PoolAllocator::print(std::cout);
+      if (perf != NULL) {
+          perf->print(std::cout);
+          delete perf;
+      }
       std::cout<<"///////////////////////"<<std::endl;
       delete q;
   
 
   return 0;
 }
-
+#endif
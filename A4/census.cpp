@@ -0,0 +1,135 @@
+/*
+ * Authors M&M
+ */
+
+#pragma once
+#include <gecode/kernel.hh>
+#include <cstdlib>
+#include <map>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
+
+using namespace Gecode;
+
+/*
+ * What a model's space is made of, to see which constraints drive the cost of cloning.
+ *
+ * While the model is built it marks where each group of constraints starts (mark());
+ * every group records the propagators, branchers and bytes posting it added to the
+ * space. A group may be marked again later (say in every round of a loop), its
+ * counts add up. Afterwards sample() counts the propagators of a space by class, at
+ * the root after propagation and at sampled search nodes. Subsumed propagators are
+ * gone by then, so the samples show what a clone actually has to copy.
+ */
+class Census {
+protected:
+  // A group of constraints posted by the model
+  struct Category {
+    std::string name;
+    unsigned int propagators, branchers;
+    long bytes;
+  };
+  std::vector<Category> built;
+  // Declared variables by name
+  std::vector<std::pair<std::string, int> > vars;
+  // Open group and the space's counts when it was opened
+  bool open;
+  Category start;
+  // Sampled spaces: propagators by class summed over all samples
+  std::map<std::string, unsigned long int> classes;
+  unsigned long int samples, propagators, branchers, bytes;
+
+  // Readable name of the class of propagator p
+  static std::string name(const Propagator& p) {
+    const char* n = typeid(p).name();
+#ifdef __GNUC__
+    int status;
+    char* d = abi::__cxa_demangle(n, NULL, NULL, &status);
+    if (d != NULL) {
+      std::string r(d);
+      free(d);
+      // Drop template arguments, they only tell views apart
+      size_t t = r.find('<');
+      return (t == std::string::npos) ? r : r.substr(0, t);
+    }
+#endif
+    return n;
+  }
+
+  void close(const Space& home) {
+    if (!open)
+      return;
+    size_t i = 0;
+    while ((i < built.size()) && (built[i].name != start.name))
+      i++;
+    if (i == built.size()) {
+      Category c;
+      c.name = start.name;
+      c.propagators = 0; c.branchers = 0; c.bytes = 0;
+      built.push_back(c);
+    }
+    built[i].propagators += home.propagators() - start.propagators;
+    built[i].branchers += home.branchers() - start.branchers;
+    built[i].bytes += static_cast<long>(home.allocated()) - start.bytes;
+    open = false;
+  }
+
+public:
+  Census(void) : open(false), samples(0), propagators(0), branchers(0), bytes(0) {}
+
+  // Everything posted from here up to the next mark belongs to group name (NULL: none)
+  static void mark(Census* c, const Space& home, const char* name) {
+    if (c == NULL)
+      return;
+    c->close(home);
+    if (name != NULL) {
+      c->start.name = name;
+      c->start.propagators = home.propagators();
+      c->start.branchers = home.branchers();
+      c->start.bytes = static_cast<long>(home.allocated());
+      c->open = true;
+    }
+  }
+  // The model declares n variables called name
+  static void variables(Census* c, const char* name, int n) {
+    if (c != NULL)
+      c->vars.push_back(std::make_pair(std::string(name), n));
+  }
+
+  // Count the propagators, branchers and bytes of home (after propagation)
+  void sample(Space& home) {
+    samples++;
+    propagators += home.propagators();
+    branchers += home.branchers();
+    bytes += home.allocated();
+    for (Space::Propagators p(home); p(); ++p)
+      classes[name(p.propagator())]++;
+  }
+
+  void print(std::ostream& os) const {
+    os << "declared variables:";
+    for (size_t i=0; i<vars.size(); i++)
+      os << " " << vars[i].first << ":" << vars[i].second;
+    os << std::endl << "posted by model part (propagators, branchers, bytes):" << std::endl;
+    for (size_t i=0; i<built.size(); i++)
+      os << "  " << built[i].name << ": " << built[i].propagators << ", "
+         << built[i].branchers << ", " << built[i].bytes << std::endl;
+    if (samples == 0)
+      return;
+    os << "average over " << samples << " sampled space(s): propagators: "
+       << static_cast<double>(propagators) / samples << ", branchers: "
+       << static_cast<double>(branchers) / samples << ", bytes: "
+       << static_cast<double>(bytes) / samples << std::endl
+       << "propagators by class:" << std::endl;
+    for (std::map<std::string, unsigned long int>::const_iterator
+           i=classes.begin(); i != classes.end(); ++i)
+      os << "  " << i->first << ": " << static_cast<double>(i->second) / samples
+         << std::endl;
+  }
+};
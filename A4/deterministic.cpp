@@ -0,0 +1,382 @@
+/*
+ * Authors M&M
+ */
+
+#pragma once
+#include <gecode/search.hh>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+#include "placement.cpp"
+#include "shave.cpp"
+
+using namespace Gecode;
+
+/*
+ * Deterministic parallel search.
+ *
+ * The tree is split at a fixed depth: the root is expanded sequentially, left to
+ * right, down to that depth, and every open node becomes a subtree with an index in
+ * that order. Each subtree is then searched by a sequential Gecode engine on some
+ * worker thread. Which thread gets which subtree does not matter, as a sequential
+ * engine on a given subtree always does the same work; results are combined in
+ * subtree order only. So the same split depth and thread count always give the same
+ * solutions and statistics.
+ *
+ * With NUMA placement every node gets a queue holding every nodes()-th subtree (so
+ * all nodes start at the left, where first solution search needs the work done),
+ * its workers are pinned to its cores and take from that queue first, and only then
+ * steal from the other nodes' queues. Engines clone their subtree root in
+ * the worker, so the spaces of a search live in the worker's node.
+ *
+ * With shaving (see shave()) every subtree root is shaved by its worker before it
+ * is searched.
+ *
+ * The caller's search options are passed on to the subtree engines (one thread
+ * each). Its stop object is asked every so many nodes, serialized, with the totals
+ * of the split, the finished subtrees and the asking subtree; once it says stop,
+ * every subtree stops. Where it stops depends on timing, so a run cut short by a
+ * limit or a gap is not reproducible.
+ */
+template<class T>
+class DeterministicSplit {
+protected:
+  // Subtree roots in left-to-right order, solutions met while splitting are kept too
+  std::vector<T*> subtree;
+  // Statistics of the splitting itself
+  Search::Statistics split;
+  unsigned int threads;
+  Placement placement;
+  // Milliseconds spent in subtree searches summed over workers, and elapsed
+  double work, wall;
+  // Whether to shave subtree roots, and the values shaving removed
+  bool shaving;
+  std::atomic<unsigned long int> shaved;
+  // Caller's options, the statistics of the split and finished subtrees for its
+  // stop object, and whether that stopped the search
+  Search::Options opt;
+  std::mutex m;
+  Search::Statistics finished;
+  std::atomic<bool> _stopped;
+
+  // Stop object of a subtree engine: asks the caller's every 32 nodes
+  class Forward : public Search::Stop {
+  protected:
+    DeterministicSplit& d;
+    unsigned long int calls;
+  public:
+    Forward(DeterministicSplit& d0) : d(d0), calls(0) {}
+    virtual bool stop(const Search::Statistics& s, const Search::Options& o) {
+      if (d._stopped.load(std::memory_order_relaxed))
+        return true;
+      if ((d.opt.stop == NULL) || ((++calls & 31) != 0))
+        return false;
+      std::lock_guard<std::mutex> l(d.m);
+      Search::Statistics t = d.finished;
+      add(t, s);
+      if (d.opt.stop->stop(t, o))
+        d._stopped.store(true);
+      return d._stopped.load();
+    }
+  };
+
+  // Options for a subtree engine stopped by c
+  Search::Options options(Search::Stop* c) const {
+    Search::Options o = opt;
+    o.threads = 1;
+    o.stop = c;
+    return o;
+  }
+  // A subtree search with statistics s is over
+  void finish(const Search::Statistics& s) {
+    std::lock_guard<std::mutex> l(m);
+    add(finished, s);
+  }
+
+  // Get subtree root s ready for search
+  void prepare(T* s) {
+    if (!shaving)
+      return;
+    typename Shaving<T>::Statistics st;
+    (void) Shaving<T>::shave(s, 1, st);
+    shaved += st.removed;
+  }
+
+  // Expand s (at depth d) down to depth max, s is owned afterwards
+  void expand(T* s, unsigned int d, unsigned int max) {
+    StatusStatistics ss;
+    SpaceStatus st = s->status(ss);
+    split.node++;
+    split.propagate += ss.propagate;
+    split.depth = std::max(split.depth, static_cast<unsigned long int>(d));
+    if (st == SS_FAILED) {
+      split.fail++;
+      delete s;
+    } else if ((st == SS_SOLVED) || (d == max)) {
+      subtree.push_back(s);
+    } else {
+      const Choice* c = s->choice();
+      for (unsigned int a=0; a<c->alternatives(); a++) {
+        // Spaces go to other threads, so nothing may be shared
+        T* t = static_cast<T*>(s->clone(false));
+        t->commit(*c, a);
+        expand(t, d+1, max);
+      }
+      delete c;
+      delete s;
+    }
+  }
+
+  // Run job(i) for every subtree i in [from,to) on the worker threads
+  template<class Job>
+  void parallel(int from, int to, Job job) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    // One queue per node, queue k holds subtrees from+k, from+k+nodes, ... below to
+    int nodes = static_cast<int>(placement.nodes());
+    std::vector<std::atomic<int> > next(nodes);
+    for (int k=0; k<nodes; k++)
+      next[k] = from + k;
+    std::atomic<long> busy(0);
+    std::vector<std::thread> w;
+    for (unsigned int t=0; t<threads; t++)
+      w.push_back(std::thread([&, t] {
+        placement.pin(t);
+        int home = static_cast<int>(placement.node(t));
+        for (int d=0; d<nodes; d++) {
+          int k = (home + d) % nodes;
+          for (int i=next[k].fetch_add(nodes); i<to; i=next[k].fetch_add(nodes)) {
+            std::chrono::steady_clock::time_point s = std::chrono::steady_clock::now();
+            job(i);
+            busy += std::chrono::duration_cast<std::chrono::microseconds>
+              (std::chrono::steady_clock::now() - s).count();
+          }
+        }
+      }));
+    for (size_t t=0; t<w.size(); t++)
+      w[t].join();
+    work += busy / 1000.0;
+    wall += std::chrono::duration_cast<std::chrono::microseconds>
+      (std::chrono::steady_clock::now() - start).count() / 1000.0;
+  }
+
+  static void add(Search::Statistics& s, const Search::Statistics& t) {
+    s.fail += t.fail;
+    s.node += t.node;
+    s.propagate += t.propagate;
+    s.depth = std::max(s.depth, t.depth);
+    s.memory = std::max(s.memory, t.memory);
+  }
+
+public:
+  DeterministicSplit(T* root, unsigned int t, unsigned int depth, bool numa = false,
+                     const Search::Options& o = Search::Options::def)
+    : threads(std::max(t, 1U)), placement(numa), work(0), wall(0),
+      shaving(false), shaved(0), opt(o), _stopped(false) {
+    expand(static_cast<T*>(root->clone(false)), 0, depth);
+    finished = split;
+  }
+  ~DeterministicSplit(void) {
+    for (size_t i=0; i<subtree.size(); i++)
+      delete subtree[i];
+  }
+  // Number of subtrees the split produced
+  size_t subtrees(void) const {
+    return subtree.size();
+  }
+  // Shave every subtree root before searching it
+  void shave(bool b) {
+    shaving = b;
+  }
+  // Whether the caller's stop object stopped the search
+  bool stopped(void) const {
+    return _stopped.load();
+  }
+  /*
+   * Speedup of the parallel part over b, the same search (same split depth) run to
+   * the end on one worker: its elapsed time over ours.
+   */
+  void speedup(std::ostream& os, const DeterministicSplit<T>& b) const {
+    os << "speedup over 1 worker: " << ((wall > 0) ? b.wall / wall : 0)
+       << " (1 worker: " << b.wall << " ms, " << threads << " workers: " << wall
+       << " ms)" << std::endl;
+  }
+  /*
+   * Elapsed time of the parallel part and the workers' utilisation: summed busy
+   * time over elapsed time, at most the number of workers. This is not a speedup
+   * over sequential search, the split may make the total search larger.
+   */
+  void print(std::ostream& os) const {
+    os << "workers: " << threads << " on " << placement.nodes() << " node(s), "
+       << "parallel time: " << wall << " ms, utilisation (busy/wall): "
+       << ((wall > 0) ? work / wall : 0) << std::endl;
+    if (shaving)
+      os << "shaving removed " << shaved.load() << " values from subtree roots"
+         << std::endl;
+  }
+};
+
+/*
+ * First solution search: the solution of the leftmost subtree that has one. The
+ * statistics count the split and the subtrees up to and including that one; work in
+ * subtrees further right is cut short and left out, as it depends on timing.
+ */
+template<class T>
+class DeterministicDFS : public DeterministicSplit<T> {
+protected:
+  using DeterministicSplit<T>::subtree;
+  // Stops a subtree once one further left has a solution, or the caller says so
+  class Cutoff : public DeterministicSplit<T>::Forward {
+  public:
+    const std::atomic<int>& first;
+    int index;
+    Cutoff(DeterministicSplit<T>& d, const std::atomic<int>& f, int i)
+      : DeterministicSplit<T>::Forward(d), first(f), index(i) {}
+    virtual bool stop(const Search::Statistics& s, const Search::Options& o) {
+      return (first.load(std::memory_order_relaxed) < index) ||
+        DeterministicSplit<T>::Forward::stop(s, o);
+    }
+  };
+  Search::Statistics stat;
+  bool done;
+public:
+  DeterministicDFS(T* root, unsigned int t, unsigned int depth, bool numa = false,
+                   const Search::Options& o = Search::Options::def)
+    : DeterministicSplit<T>(root, t, depth, numa, o), done(false) {}
+
+  T* next(void) {
+    if (done)
+      return NULL;
+    done = true;
+    int n = static_cast<int>(subtree.size());
+    std::vector<T*> solution(n, static_cast<T*>(NULL));
+    std::vector<Search::Statistics> sub(n);
+    std::atomic<int> first(n);
+    this->parallel(0, n, [&] (int i) {
+      if (first.load() < i)
+        return;
+      this->prepare(subtree[i]);
+      Cutoff c(*this, first, i);
+      DFS<T> e(subtree[i], this->options(&c));
+      solution[i] = e.next();
+      sub[i] = e.statistics();
+      this->finish(sub[i]);
+      if (solution[i] != NULL) {
+        int f = first.load();
+        while ((i < f) && !first.compare_exchange_weak(f, i))
+          ;
+      }
+    });
+    stat = this->split;
+    T* s = NULL;
+    for (int i=0; i<n; i++) {
+      if (s == NULL) {
+        this->add(stat, sub[i]);
+        s = solution[i];
+      } else {
+        delete solution[i];
+      }
+    }
+    return s;
+  }
+
+  const Search::Statistics& statistics(void) const {
+    return stat;
+  }
+};
+
+/*
+ * Best solution search: subtrees are searched in rounds of as many subtrees as
+ * there are threads. Every subtree of a round is bounded by the best solution found
+ * before the round, and at the end of the round the subtrees' best solutions are
+ * offered in subtree order. next() hands out every improvement in that order.
+ */
+template<class T>
+class DeterministicBAB : public DeterministicSplit<T> {
+protected:
+  using DeterministicSplit<T>::subtree;
+  using DeterministicSplit<T>::threads;
+  Search::Statistics stat;
+  // Best solution so far and improvements not yet handed out
+  T* best;
+  std::vector<T*> pending;
+  // First subtree of the next round
+  int round;
+
+  // Whether s is better than the best solution so far
+  bool better(T* s) const {
+    if (best == NULL)
+      return true;
+    T* t = static_cast<T*>(s->clone(false));
+    t->constrain(*best);
+    bool b = t->status() != SS_FAILED;
+    delete t;
+    return b;
+  }
+
+  void search(int from, int to) {
+    int n = to - from;
+    std::vector<T*> solution(n, static_cast<T*>(NULL));
+    std::vector<Search::Statistics> sub(n);
+    this->parallel(from, to, [&] (int i) {
+      T* r = subtree[i];
+      subtree[i] = NULL;
+      if (best != NULL)
+        r->constrain(*best);
+      this->prepare(r);
+      typename DeterministicSplit<T>::Forward f(*this);
+      BAB<T> e(r, this->options(&f));
+      delete r;
+      while (T* s = e.next()) {
+        delete solution[i-from];
+        solution[i-from] = s;
+      }
+      sub[i-from] = e.statistics();
+      this->finish(sub[i-from]);
+    });
+    for (int i=0; i<n; i++) {
+      this->add(stat, sub[i]);
+      if ((solution[i] != NULL) && better(solution[i])) {
+        delete best;
+        best = static_cast<T*>(solution[i]->clone(false));
+        pending.push_back(solution[i]);
+      } else {
+        delete solution[i];
+      }
+    }
+  }
+
+public:
+  DeterministicBAB(T* root, unsigned int t, unsigned int depth, bool numa = false,
+                   const Search::Options& o = Search::Options::def)
+    : DeterministicSplit<T>(root, t, depth, numa, o), best(NULL), round(0) {
+    stat = this->split;
+  }
+  ~DeterministicBAB(void) {
+    for (size_t i=0; i<pending.size(); i++)
+      delete pending[i];
+    delete best;
+  }
+
+  T* next(void) {
+    while (pending.empty() && !this->stopped() &&
+           (round < static_cast<int>(subtree.size()))) {
+      int to = std::min(round + static_cast<int>(threads),
+                        static_cast<int>(subtree.size()));
+      search(round, to);
+      round = to;
+    }
+    if (pending.empty())
+      return NULL;
+    T* s = pending.front();
+    pending.erase(pending.begin());
+    return s;
+  }
+
+  const Search::Statistics& statistics(void) const {
+    return stat;
+  }
+};
@@ -0,0 +1,87 @@
+/*
+ * Authors M&M
+ */
+
+#pragma once
+#include <gecode/search.hh>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cmath>
+
+using namespace Gecode;
+
+/*
+ * Knuth's random-probe estimate of the size of a search tree.
+ *
+ * Every probe dives from the root to a leaf (a solution or a failure), taking a
+ * random alternative at every choice. With b1, b2, ... the number of alternatives
+ * met on the way, 1 + b1 + b1*b2 + ... is an unbiased estimate of the number of
+ * nodes in the full tree; the average over all probes is reported together with
+ * its standard error.
+ *
+ * The tree is the one DFS would explore to exhaustion, so for a run that stops
+ * at its first solution the estimate is an upper bound.
+ */
+class TreeEstimate {
+public:
+  // Estimated number of nodes
+  double nodes;
+  // Standard error of the estimate
+  double error;
+  // Number of probes actually made
+  unsigned int probes;
+  // Average depth of a probe
+  double depth;
+
+  TreeEstimate(void) : nodes(0.0), error(0.0), probes(0), depth(0.0) {}
+
+  /*
+   * Probe the tree below root at most n times, but stop after ms milliseconds.
+   * root must not be failed; it is left unchanged apart from being propagated.
+   */
+  static TreeEstimate probe(Space* root, unsigned int n, unsigned int ms,
+                            unsigned int seed) {
+    TreeEstimate e;
+    if (root->status() == SS_FAILED)
+      return e;
+    std::mt19937 rnd(seed);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    double sum = 0.0, sum2 = 0.0, depths = 0.0;
+    while (e.probes < n) {
+      // Unshared, so that random dives leave shared model state (saved phases) alone
+      Space* s = root->clone(false);
+      double width = 1.0, size = 1.0;
+      unsigned int d = 0;
+      while (s->status() == SS_BRANCH) {
+        const Choice* c = s->choice();
+        unsigned int a = c->alternatives();
+        width *= a;
+        size += width;
+        s->commit(*c, std::uniform_int_distribution<unsigned int>(0, a-1)(rnd));
+        delete c;
+        d++;
+      }
+      delete s;
+      sum += size; sum2 += size * size; depths += d;
+      e.probes++;
+      if (std::chrono::duration_cast<std::chrono::milliseconds>
+          (std::chrono::steady_clock::now() - start).count() >= ms)
+        break;
+    }
+    if (e.probes == 0)
+      return e;
+    e.nodes = sum / e.probes;
+    e.depth = depths / e.probes;
+    if (e.probes > 1) {
+      double var = (sum2 - sum * sum / e.probes) / (e.probes - 1);
+      e.error = std::sqrt(std::max(var, 0.0) / e.probes);
+    }
+    return e;
+  }
+
+  void print(std::ostream& os) const {
+    os << "estimated nodes: " << nodes << " (+/- " << error << ", "
+       << probes << " probes, average depth " << depth << ")" << std::endl;
+  }
+};
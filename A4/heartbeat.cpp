@@ -0,0 +1,158 @@
+/*
+ * Authors M&M
+ */
+
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Background reporter for long runs. Every interval it writes one line of JSON with
+ * the search throughput seen by a SearchMonitor:
+ *
+ *   {"time":12.0,"nodes":81920,"failures":40950,"nodes_per_sec":6826.7,
+ *    "failures_per_sec":3412.5,"depth":17,"max_depth":31,"peak_memory_kb":10240,
+ *    "bound":70,"dual":72,"gap":0.0286}
+ *
+ * The target is a file name, or "unix:PATH" for a Unix stream socket (Linux only).
+ * "depth" is the depth of the node being explored where the engine publishes it
+ * (the histogram engine, -histogram or -census), null otherwise: Gecode's statistics
+ * keep no current depth. "max_depth" is the deepest the search has been so far. "bound" and "dual" are the monitor's primal and dual bounds, "gap"
+ * their relative gap; each is null while unknown.
+ */
+class Heartbeat {
+protected:
+  const SearchMonitor& monitor;
+  unsigned int interval;
+  // Output: either a file or a socket
+  FILE* file;
+  int sock;
+  // Reporter thread and its shutdown signal
+  std::thread thread;
+  std::mutex m;
+  std::condition_variable cv;
+  bool done;
+  // Previous sample for the rates
+  double last_time;
+  unsigned long int last_node, last_fail;
+
+  // Peak resident memory in KB, 0 where unknown
+  static long peak_memory(void) {
+#ifdef __linux__
+    struct rusage u;
+    if (getrusage(RUSAGE_SELF, &u) == 0)
+      return u.ru_maxrss;
+#endif
+    return 0;
+  }
+
+  void write(const std::string& line) {
+    if (file != NULL) {
+      fputs(line.c_str(), file);
+      fflush(file);
+    }
+#ifdef __linux__
+    if ((sock >= 0) && (send(sock, line.c_str(), line.size(), MSG_NOSIGNAL) < 0)) {
+      // The agent went away, keep searching without it
+      close(sock);
+      sock = -1;
+    }
+#endif
+  }
+
+  void sample(void) {
+    double t = monitor.elapsed();
+    unsigned long int n = monitor.node(), f = monitor.fail();
+    double dt = t - last_time;
+    char buf[512];
+    int l = snprintf(buf, sizeof(buf),
+                     "{\"time\":%.3f,\"nodes\":%lu,\"failures\":%lu,"
+                     "\"nodes_per_sec\":%.1f,\"failures_per_sec\":%.1f,"
+                     "\"depth\":",
+                     t, n, f,
+                     dt > 0.0 ? (n - last_node) / dt : 0.0,
+                     dt > 0.0 ? (f - last_fail) / dt : 0.0);
+    std::string line(buf, l);
+    line += monitor.current_known() ? std::to_string(monitor.current_depth()) : "null";
+    l = snprintf(buf, sizeof(buf), ",\"max_depth\":%lu,\"peak_memory_kb\":%ld,\"bound\":",
+                 monitor.depth(), peak_memory());
+    line.append(buf, l);
+    line += monitor.primal_known() ? std::to_string(monitor.primal()) : "null";
+    line += ",\"dual\":";
+    line += monitor.dual_known() ? std::to_string(monitor.dual()) : "null";
+    line += ",\"gap\":";
+    if (monitor.primal_known() && monitor.dual_known()) {
+      snprintf(buf, sizeof(buf), "%.4f", monitor.gap());
+      line += buf;
+    } else {
+      line += "null";
+    }
+    line += "}\n";
+    write(line);
+    last_time = t; last_node = n; last_fail = f;
+  }
+
+  void run(void) {
+    std::unique_lock<std::mutex> l(m);
+    while (!cv.wait_for(l, std::chrono::milliseconds(interval),
+                        [this] { return done; }))
+      sample();
+    // Final line so the agent sees the end state
+    sample();
+  }
+
+public:
+  Heartbeat(const SearchMonitor& m0, const char* target, unsigned int i)
+    : monitor(m0), interval(i > 0 ? i : 1000), file(NULL), sock(-1),
+      done(false),
+      last_time(0.0), last_node(0), last_fail(0) {
+    if (strncmp(target, "unix:", 5) == 0) {
+#ifdef __linux__
+      struct sockaddr_un a;
+      memset(&a, 0, sizeof(a));
+      a.sun_family = AF_UNIX;
+      strncpy(a.sun_path, target + 5, sizeof(a.sun_path) - 1);
+      sock = socket(AF_UNIX, SOCK_STREAM, 0);
+      if ((sock >= 0) &&
+          (connect(sock, reinterpret_cast<struct sockaddr*>(&a), sizeof(a)) < 0)) {
+        close(sock);
+        sock = -1;
+      }
+#endif
+      if (sock < 0)
+        std::cerr << "heartbeat: cannot connect to " << target << std::endl;
+    } else {
+      file = fopen(target, "a");
+      if (file == NULL)
+        std::cerr << "heartbeat: cannot open " << target << std::endl;
+    }
+    thread = std::thread(&Heartbeat::run, this);
+  }
+
+  ~Heartbeat(void) {
+    {
+      std::lock_guard<std::mutex> l(m);
+      done = true;
+    }
+    cv.notify_one();
+    thread.join();
+    if (file != NULL)
+      fclose(file);
+#ifdef __linux__
+    if (sock >= 0)
+      close(sock);
+#endif
+  }
+};
@@ -27,12 +27,24 @@
  *
  */
 
+#pragma once
+
 #include <gecode/int.hh>
 
 using namespace Gecode;
 
 using namespace Gecode::Int;
 
+/*
+ * Whether the interval branching with share p still splits x of width w: x is not
+ * assigned and its compulsory part (min + w - max) is still shorter than p*w (see
+ * IntervalBrancher::status()).
+ */
+template<class View>
+inline bool intervalSplits(const View& x, int w, double p) {
+  return !x.assigned() && (x.min() + w) - x.max() < p*w;
+}
+
 /*
  * Custom brancher for forcing mandatory parts
  *
@@ -101,7 +113,7 @@ public:
   virtual bool status(const Space& home) const {
     // FILL IN HERE
        for (int i = start; i < x.size(); i++) {
-           if ((x[i].min() + w[i]) - x[i].max()< p*w[i] && !x[i].assigned()) {
+           if (intervalSplits(x[i], w[i], p)) {
                start = i;
                return true;
            }
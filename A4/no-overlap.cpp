@@ -27,7 +27,12 @@
  *
  */
 
+#pragma once
+
 #include <gecode/int.hh>
+#include <algorithm>
+#include <cmath>
+#include "perf-counters.cpp"
 
 using namespace Gecode;
 using namespace Gecode::Int;
@@ -43,14 +48,89 @@ protected:
   ViewArray<IntView> y;
   // The heights (array)
   int* h;
+  // The size of the square container (if container is set)
+  IntView s;
+  bool container;
+  // Total area of the rectangles
+  int area;
+  /*
+   * Pairs (s1*n + s2) that failed or pruned most recently, most recent first, -1 for
+   * unused. Shared by all copies of the propagator in a thread (a failure is found
+   * in a space that is thrown away, its parent and siblings are the ones to learn
+   * from), separate per thread as clones for other threads are made without sharing.
+   */
+  static const int RECENT = 8;
+  SharedArray<int> mtf;
+  /*
+   * Pairs that may still overlap: bit s2 of row s1 (s1 < s2), rows of words words
+   * each. Once a pair is separated it stays so below, so its bit is cleared and the
+   * pair is never looked at again; alive counts the bits left.
+   */
+  typedef unsigned long long int Word;
+  static const int BITS = 64;
+  int words;
+  Word* live;
+  int alive;
+
+  void initLive(Space& home) {
+    int n = x.size();
+    words = (n + BITS - 1) / BITS;
+    live = home.alloc<Word>(n*words);
+    for (int i = n*words; i--; )
+      live[i] = 0;
+    for (int s1 = 0; s1 < n; s1++)
+      for (int s2 = s1 + 1; s2 < n; s2++)
+        live[s1*words + s2/BITS] |= Word(1) << (s2 % BITS);
+    alive = n*(n-1)/2;
+  }
+  bool isLive(int s1, int s2) const {
+    return (live[s1*words + s2/BITS] >> (s2 % BITS)) & 1;
+  }
+  void separate(int s1, int s2) {
+    live[s1*words + s2/BITS] &= ~(Word(1) << (s2 % BITS));
+    alive--;
+  }
+  // Position of the lowest bit set in b (b is not 0)
+  static int lowest(Word b) {
+#ifdef __GNUC__
+    return __builtin_ctzll(b);
+#else
+    int i = 0;
+    while (!((b >> i) & 1))
+      i++;
+    return i;
+#endif
+  }
+
+  void initRecent(Home home) {
+    mtf.init(RECENT);
+    for (int k = 0; k < RECENT; k++)
+      mtf[k] = -1;
+    home.notice(*this,AP_DISPOSE);
+  }
 public:
   // Create propagator and initialize
   NoOverlap(Home home, 
             ViewArray<IntView>& x0, int w0[], 
             ViewArray<IntView>& y0, int h0[])
-    : Propagator(home), x(x0), w(w0), y(y0), h(h0) {
+    : Propagator(home), x(x0), w(w0), y(y0), h(h0), container(false), area(0) {
+    x.subscribe(home,*this,PC_INT_BND);
+    y.subscribe(home,*this,PC_INT_BND);
+    initRecent(home);
+    initLive(home);
+  }
+  // Create propagator with the container s and initialize
+  NoOverlap(Home home, 
+            ViewArray<IntView>& x0, int w0[], 
+            ViewArray<IntView>& y0, int h0[], IntView s0)
+    : Propagator(home), x(x0), w(w0), y(y0), h(h0), s(s0), container(true), area(0) {
     x.subscribe(home,*this,PC_INT_BND);
     y.subscribe(home,*this,PC_INT_BND);
+    s.subscribe(home,*this,PC_INT_BND);
+    for (int i=x.size(); i--; )
+      area += w[i]*h[i];
+    initRecent(home);
+    initLive(home);
   }
   // Post no-overlap propagator
   static ExecStatus post(Home home, 
@@ -61,109 +141,247 @@ public:
       (void) new (home) NoOverlap(home,x,w,y,h);
     return ES_OK;
   }
+  // Post no-overlap propagator with container, also needed for a single rectangle
+  static ExecStatus post(Home home, 
+                         ViewArray<IntView>& x, int w[], 
+                         ViewArray<IntView>& y, int h[], IntView s) {
+    if (x.size() > 0)
+      (void) new (home) NoOverlap(home,x,w,y,h,s);
+    return ES_OK;
+  }
 
   // Copy constructor during cloning
   NoOverlap(Space& home, bool share, NoOverlap& p)
-    : Propagator(home,share,p) {
+    : Propagator(home,share,p), container(p.container), area(p.area) {
     x.update(home,share,p.x);
     y.update(home,share,p.y);
+    if (container)
+      s.update(home,share,p.s);
+    mtf.update(home,share,p.mtf);
     // Also copy width and height arrays
     w = home.alloc<int>(x.size());
     h = home.alloc<int>(y.size());
     for (int i=x.size(); i--; ) {
       w[i]=p.w[i]; h[i]=p.h[i];
     }
+    // And the pairs still alive
+    words = p.words;
+    alive = p.alive;
+    live = home.alloc<Word>(x.size()*words);
+    for (int i=x.size()*words; i--; )
+      live[i] = p.live[i];
   }
   // Create copy during cloning
   virtual Propagator* copy(Space& home, bool share) {
     return new (home) NoOverlap(home,share,*this);
   }
 
+  /*
+   * Propagation between the rectangles and the container s:
+   *  - every rectangle lies inside: x[i] + w[i] <= s, y[i] + h[i] <= s
+   *  - the rectangles fit: s*s >= total area
+   *  - the compulsory parts (the stretch [x.max, x.min + w) a rectangle covers
+   *    wherever it goes) that overlap in some column are stacked in it, so their
+   *    heights add up to at most s; the same for rows.
+   */
+  ExecStatus propagateContainer(Space& home) {
+    int n = x.size();
+    for (int i=0; i<n; i++) {
+      GECODE_ME_CHECK(x[i].lq(home, s.max() - w[i]));
+      GECODE_ME_CHECK(y[i].lq(home, s.max() - h[i]));
+      GECODE_ME_CHECK(s.gq(home, std::max(x[i].min() + w[i], y[i].min() + h[i])));
+    }
+    int side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(area))));
+    GECODE_ME_CHECK(s.gq(home, side));
+    GECODE_ME_CHECK(s.gq(home, compulsory(home, x, w, h)));
+    GECODE_ME_CHECK(s.gq(home, compulsory(home, y, h, w)));
+    return ES_OK;
+  }
+
+  /*
+   * Largest sum of the extents e of rectangles whose compulsory parts in p (with sizes
+   * l) overlap at some coordinate: sweep over the starts and ends of the parts.
+   */
+  int compulsory(Space& home, const ViewArray<IntView>& p, const int* l,
+                 const int* e) const {
+    Region r(home);
+    // Events: coordinate, +e at a start and -e at an end
+    std::pair<int,int>* ev = r.alloc<std::pair<int,int> >(2*p.size());
+    int m = 0;
+    for (int i=p.size(); i--; )
+      if (p[i].max() < p[i].min() + l[i]) {
+        ev[m++] = std::make_pair(p[i].max(), e[i]);
+        ev[m++] = std::make_pair(p[i].min() + l[i], -e[i]);
+      }
+    // Ends sort before starts at the same coordinate (parts are half-open)
+    std::sort(ev, ev + m);
+    int load = 0, peak = 0;
+    for (int k=0; k<m; k++) {
+      load += ev[k].second;
+      peak = std::max(peak, load);
+    }
+    return peak;
+  }
+
   // Return cost (defined as cheap quadratic)
   virtual PropCost cost(const Space&, const ModEventDelta&) const {
     return PropCost::quadratic(PropCost::LO,2*x.size());
   }
 
+  // Whether me failed, pruned is set if me changed a domain
+  static bool failed(ModEvent me, bool& pruned) {
+	  if (me_failed(me))
+		  return true;
+	  if (me != ME_INT_NONE)
+		  pruned = true;
+	  return false;
+  }
+
+  /*
+   * Propagate between rectangles s1 and s2. pruned is set if a bound moved, separated
+   * is cleared if the two may still overlap in some direction.
+   */
+  ExecStatus pair(Space& home, int s1, int s2, bool& pruned, bool& separated) {
+	  // if not left && not right && not above && not below
+	  if (
+		  (x[s2].min() + w[s2] > x[s1].max()) && 
+		  (x[s1].min() + w[s1] > x[s2].max()) && 
+		  (y[s1].min() + h[s1] > y[s2].max()) && 
+		  (y[s2].min() + h[s2] > y[s1].max())
+		  ) {
+			  return ES_FAILED;
+	  }
+	  
+	  //if s1 and s2 overlap horizontally
+	  //s2 can not be at the left of s1 && If s2 cannot be at the right of s1 && If s2 cannot be above s1
+	  if (
+		  (x[s2].min() + w[s2] > x[s1].max()) &&
+		  (x[s1].min() + w[s1] > x[s2].max()) &&
+		  (y[s1].min() + h[s1] > y[s2].max())
+		  )
+	  {
+		  // Enforce s2 below s1
+		  if (failed(y[s2].lq(home, y[s1].max() - h[s2]), pruned) ||
+			  failed(y[s1].gq(home, y[s2].min() + h[s2]), pruned))
+			  return ES_FAILED;
+	  }
+	  
+	  // s2 can not be at the right of s1 && If s2 cannot be at the left of s1 && If s2 cannot be below s1
+	  if (
+		  (x[s1].min() + w[s1] > x[s2].max()) &&
+		  (x[s2].min() + w[s2] > x[s1].max()) &&
+		  (y[s2].min() + h[s2] > y[s1].max())
+		  )
+	  {
+		  // Enforce s2 above s1
+		  if (failed(y[s2].gq(home, y[s1].min() + h[s1]), pruned) ||
+			  failed(y[s1].lq(home, y[s2].max() - h[s1]), pruned))
+			  return ES_FAILED;
+	  }
+	  
+	  //if s1 and s2 overlap verticaly
+	  // s2 can not be below s1 && If s2 cannot be above s1 && If s2 cannot be at the left of s1
+	  if (
+		  (y[s2].min() + h[s2] > y[s1].max()) &&
+		  (y[s1].min() + h[s1] > y[s2].max()) &&
+		  (x[s2].min() + w[s2] > x[s1].max())
+		  )
+	  {
+		  // Enforce s2 to the right of s1
+		  if (failed(x[s2].gq(home, x[s1].min() + w[s1]), pruned) ||
+			  failed(x[s1].lq(home, x[s2].max() - w[s1]), pruned))
+			  return ES_FAILED;
+	  }
+	  
+	  // s2 can not be above s1 && If s2 cannot be below s1 && If s2 cannot be at the right of s1
+	  if (
+		  (y[s1].min() + h[s1] > y[s2].max()) &&
+		  (y[s2].min() + h[s2] > y[s1].max()) &&
+		  (x[s1].min() + w[s1] > x[s2].max())
+		  )
+	  {
+		  // Enforce s2 left of s1
+		  if (failed(x[s2].lq(home, x[s1].max() - w[s2]), pruned) ||
+			  failed(x[s1].gq(home, x[s2].min() + w[s2]), pruned))
+			  return ES_FAILED;
+	  }
+	  
+	  //check subsumption
+	  if ((x[s1].max() + w[s1] > x[s2].min()) &&
+		  (x[s2].max() + w[s2] > x[s1].min()) &&
+		  (y[s1].max() + h[s1] > y[s2].min()) &&
+		  (y[s2].max() + h[s2] > y[s1].min())){
+			  separated = false;
+	  }
+	  return ES_OK;
+  }
+
+  // Move pair p (s1*n + s2) to the front of the recent list
+  void recent(int p) {
+	  int k = 0;
+	  while ((k < RECENT-1) && (mtf[k] != p))
+		  k++;
+	  for (; k > 0; k--)
+		  mtf[k] = mtf[k-1];
+	  mtf[0] = p;
+  }
+
   // Perform propagation
   virtual ExecStatus propagate(Space& home, const ModEventDelta&) {
+	  // Sampled: reading the counters costs more than most propagations
+	  PerfCounters::Scope perf(PerfCounters::PH_PROPAGATE, 64);
+	  
+	  if (container)
+		  GECODE_ES_CHECK(propagateContainer(home));
 	  
-	  bool subsumped= true;
 	  int n = x.size();
 	  
+	  /*
+	   * Pairs that failed or pruned lately first: most nodes fail, and mostly on a
+	   * pair that failed before, so failure is usually found after a few pairs.
+	   */
+	  int first[RECENT];
+	  for (int k = 0; k < RECENT; k++)
+		  first[k] = mtf[k];
+	  for (int k = 0; k < RECENT; k++) {
+		  if (first[k] < 0)
+			  break;
+		  if (!isLive(first[k] / n, first[k] % n))
+			  continue;
+		  bool pruned = false, separated = true;
+		  if (pair(home, first[k] / n, first[k] % n, pruned, separated) == ES_FAILED) {
+			  recent(first[k]);
+			  return ES_FAILED;
+		  }
+	  }
+	  
+	  // Then all pairs still alive (the recent ones again, they are cheap to redo)
 	  for (int s1 = 0; s1 < n; s1++) {
-		  for (int s2 = s1 + 1; s2 < n; s2++) {
-
-			  // if not left && not right && not above && not below
-			  if (
-				  (x[s2].min() + w[s2] > x[s1].max()) && 
-				  (x[s1].min() + w[s1] > x[s2].max()) && 
-			      (y[s1].min() + h[s1] > y[s2].max()) && 
-			      (y[s2].min() + h[s2] > y[s1].max())
-				  ) {
+		  Word* row = live + s1*words;
+		  for (int k = 0; k < words; k++) {
+			  for (Word b = row[k]; b != 0; b &= b - 1) {
+				  int s2 = k*BITS + lowest(b);
+				  bool pruned = false, separated = true;
+				  if (pair(home, s1, s2, pruned, separated) == ES_FAILED) {
+					  recent(s1*n + s2);
 					  return ES_FAILED;
-			  }
-			  
-			  //if s1 and s2 overlap horizontally
-			  //s2 can not be at the left of s1 && If s2 cannot be at the right of s1 && If s2 cannot be above s1
-			  if (
-				  (x[s2].min() + w[s2] > x[s1].max()) &&
-				  (x[s1].min() + w[s1] > x[s2].max()) &&
-				  (y[s1].min() + h[s1] > y[s2].max())
-				  )
-			  {
-				  // Enforce s2 below s1
-				  GECODE_ME_CHECK(y[s2].lq(home, y[s1].max() - h[s2]));
-				  GECODE_ME_CHECK(y[s1].gq(home, y[s2].min() + h[s2]));
-			  }
-			  
-			  // s2 can not be at the right of s1 && If s2 cannot be at the left of s1 && If s2 cannot be below s1
-			  if (
-				  (x[s1].min() + w[s1] > x[s2].max()) &&
-				  (x[s2].min() + w[s2] > x[s1].max()) &&
-				  (y[s2].min() + h[s2] > y[s1].max())
-				  )
-			  {
-				  // Enforce s2 above s1
-				  GECODE_ME_CHECK(y[s2].gq(home, y[s1].min() + h[s1]));
-				  GECODE_ME_CHECK(y[s1].lq(home, y[s2].max() - h[s1]));
-			  }
-			  
-			  //if s1 and s2 overlap verticaly
-			  // s2 can not be below s1 && If s2 cannot be above s1 && If s2 cannot be at the left of s1
-			  if (
-				  (y[s2].min() + h[s2] > y[s1].max()) &&
-				  (y[s1].min() + h[s1] > y[s2].max()) &&
-				  (x[s2].min() + w[s2] > x[s1].max())
-				  )
-			  {
-				  // Enforce s2 to the right of s1
-				  GECODE_ME_CHECK(x[s2].gq(home, x[s1].min() + w[s1]));
-				  GECODE_ME_CHECK(x[s1].lq(home, x[s2].max() - w[s1]));
-			  }
-			  
-			  // s2 can not be above s1 && If s2 cannot be below s1 && If s2 cannot be at the right of s1
-			  if (
-				  (y[s1].min() + h[s1] > y[s2].max()) &&
-				  (y[s2].min() + h[s2] > y[s1].max()) &&
-				  (x[s1].min() + w[s1] > x[s2].max())
-				  )
-			  {
-				  // Enforce s2 left of s1
-				  GECODE_ME_CHECK(x[s2].lq(home, x[s1].max() - w[s2]));
-				  GECODE_ME_CHECK(x[s1].gq(home, x[s2].min() + w[s2]));
-			  }
-			  
-			  
-			  //check subsumption
-			  if(subsumped &&
-				  (x[s1].max() + w[s1] > x[s2].min()) &&
-				  (x[s2].max() + w[s2] > x[s1].min()) &&
-				  (y[s1].max() + h[s1] > y[s2].min()) &&
-				  (y[s2].max() + h[s2] > y[s1].min())){
-					  subsumped = false;
+				  }
+				  if (pruned)
+					  recent(s1*n + s2);
+				  if (separated)
+					  separate(s1, s2);
 			  }
 		  }
 	  }
+	  bool subsumped = (alive == 0);
+	  
+	  if (container) {
+		  // Pruning the coordinates may have enabled more on s
+		  GECODE_ES_CHECK(propagateContainer(home));
+		  // s must stay bounding the rectangles until it is fixed
+		  if (!s.assigned())
+			  subsumped = false;
+	  }
 	  
 	  if (subsumped ){
 			return  home.ES_SUBSUMED(*this);
@@ -176,6 +394,10 @@ public:
   virtual size_t dispose(Space& home) {
     x.cancel(home,*this,PC_INT_BND);
     y.cancel(home,*this,PC_INT_BND);
+    if (container)
+      s.cancel(home,*this,PC_INT_BND);
+    home.ignore(*this,AP_DISPOSE);
+    mtf.~SharedArray<int>();
     (void) Propagator::dispose(home);
     return sizeof(*this);
   }
@@ -209,4 +431,31 @@ void NoOverlap(Home home,
   // If posting failed, fail space
   if (NoOverlap::post(home,vx,wc,vy,hc) != ES_OK)
     home.fail();
-}
\ No newline at end of file
+}
+
+/*
+ * Post the constraint that the rectangles defined by the coordinates
+ * x and y and width w and height h do not overlap and lie inside the
+ * square [0,s) x [0,s).
+ *
+ * This takes the place of the linear constraints x + w <= s and
+ * y + h <= s, and also bounds s from below by the area of the
+ * rectangles and by their compulsory parts.
+ */
+void NoOverlap(Home home, 
+               const IntVarArgs& x, const IntArgs& w,
+               const IntVarArgs& y, const IntArgs& h, IntVar s) {
+  if ((x.size() != y.size()) || (x.size() != w.size()) ||
+      (y.size() != h.size()))
+    throw ArgumentSizeMismatch("nooverlap");
+  if (home.failed()) return;
+  ViewArray<IntView> vx(home,x);
+  ViewArray<IntView> vy(home,y);
+  int* wc = static_cast<Space&>(home).alloc<int>(x.size());
+  int* hc = static_cast<Space&>(home).alloc<int>(y.size());
+  for (int i=x.size(); i--; ) {
+    wc[i]=w[i]; hc[i]=h[i];
+  }
+  if (NoOverlap::post(home,vx,wc,vy,hc,IntView(s)) != ES_OK)
+    home.fail();
+}
@@ -0,0 +1,232 @@
+/*
+ * Authors M&M
+ */
+
+#pragma once
+#include <gecode/int.hh>
+#include <gecode/minimodel.hh>
+#include <gecode/search.hh>
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "no-overlap.cpp"
+#include "interval.cpp"
+
+using namespace Gecode;
+
+/*
+ * Differential check of NoOverlap and IntervalBrancher against the reified
+ * decomposition used by MODEL_REIFY.
+ *
+ * Random rectangles get random partial domains for their coordinates. For each
+ * instance we compare
+ *   (a) the bounds after propagation to fixpoint: NoOverlap must prune at least
+ *       as much as the decomposition,
+ *   (b) the number of solutions: NoOverlap must not lose or invent solutions,
+ *   (c) the number of solutions with the interval branching in front of the
+ *       value branching: the brancher must not lose solutions either.
+ * The rectangles also get a square container of random size s, posted with the
+ * linear constraints x + w <= s, y + h <= s for the reference and as part of
+ * NoOverlap otherwise.
+ * A mismatch is shrunk greedily (dropping rectangles and domain values for as long
+ * as the mismatch stays) and printed as a minimal counterexample.
+ */
+class NoOverlapCheck : public Space {
+public:
+  // One random instance
+  struct Instance {
+    std::vector<int> w, h;
+    // Domains of the x and y coordinates
+    std::vector<std::vector<int> > dx, dy;
+    // Domain of the container size
+    std::vector<int> ds;
+    int size(void) const {
+      return static_cast<int>(w.size());
+    }
+  };
+  enum {
+    CHECK_REFERENCE, CHECK_NOOVERLAP, CHECK_INTERVAL
+  };
+protected:
+  IntVarArray x, y;
+  IntVar s;
+
+  static IntSet domain(const std::vector<int>& d) {
+    return IntSet(&d[0], static_cast<int>(d.size()));
+  }
+public:
+  NoOverlapCheck(const Instance& c, int mode)
+    : x(*this, c.size()), y(*this, c.size()), s(*this, domain(c.ds)) {
+    int n = c.size();
+    IntArgs w(n), h(n);
+    for (int i=0; i<n; i++) {
+      x[i] = IntVar(*this, domain(c.dx[i]));
+      y[i] = IntVar(*this, domain(c.dy[i]));
+      w[i] = c.w[i]; h[i] = c.h[i];
+    }
+    if (mode == CHECK_REFERENCE) {
+      for (int k=0; k<n; k++)
+        for (int l=k+1; l<n; l++)
+          rel(*this, (x[k] + w[k] <= x[l]) || (x[l] + w[l] <= x[k]) ||
+                     (y[k] + h[k] <= y[l]) || (y[l] + h[l] <= y[k]));
+      for (int k=0; k<n; k++) {
+        rel(*this, x[k] + w[k] <= s);
+        rel(*this, y[k] + h[k] <= s);
+      }
+    } else {
+      NoOverlap(*this, x, w, y, h, s);
+    }
+    if (mode == CHECK_INTERVAL)
+      interval(*this, x, w, 0.7);
+    branch(*this, x, INT_VAR_NONE(), INT_VAL_MIN());
+    if (mode == CHECK_INTERVAL)
+      interval(*this, y, h, 0.7);
+    branch(*this, y, INT_VAR_NONE(), INT_VAL_MIN());
+    branch(*this, s, INT_VAL_MIN());
+  }
+
+  NoOverlapCheck(bool share, NoOverlapCheck& c) : Space(share, c) {
+    x.update(*this, share, c.x);
+    y.update(*this, share, c.y);
+    s.update(*this, share, c.s);
+  }
+  virtual Space* copy(bool share) {
+    return new NoOverlapCheck(share, *this);
+  }
+
+  // Number of solutions of instance c in the given mode
+  static unsigned long int solutions(const Instance& c, int mode) {
+    NoOverlapCheck* s = new NoOverlapCheck(c, mode);
+    DFS<NoOverlapCheck> e(s);
+    delete s;
+    unsigned long int n = 0;
+    while (NoOverlapCheck* q = e.next()) {
+      n++;
+      delete q;
+    }
+    return n;
+  }
+
+  // Describe how NoOverlap differs from the reference on c, empty if it does not
+  static std::string mismatch(const Instance& c) {
+    std::ostringstream why;
+    NoOverlapCheck* r = new NoOverlapCheck(c, CHECK_REFERENCE);
+    NoOverlapCheck* p = new NoOverlapCheck(c, CHECK_NOOVERLAP);
+    bool rf = r->status() == SS_FAILED;
+    bool pf = p->status() == SS_FAILED;
+    if (rf && !pf) {
+      why << "reference fails at the root, NoOverlap does not";
+    } else if (!rf && !pf) {
+      for (int i=0; i<c.size(); i++) {
+        if ((p->x[i].min() < r->x[i].min()) || (p->x[i].max() > r->x[i].max()))
+          why << "x[" << i << "] is " << p->x[i] << ", reference has " << r->x[i] << "; ";
+        if ((p->y[i].min() < r->y[i].min()) || (p->y[i].max() > r->y[i].max()))
+          why << "y[" << i << "] is " << p->y[i] << ", reference has " << r->y[i] << "; ";
+      }
+      if ((p->s.min() < r->s.min()) || (p->s.max() > r->s.max()))
+        why << "s is " << p->s << ", reference has " << r->s << "; ";
+    }
+    delete r;
+    delete p;
+    if (!why.str().empty())
+      return "weaker pruning: " + why.str();
+    unsigned long int sr = solutions(c, CHECK_REFERENCE);
+    unsigned long int sp = solutions(c, CHECK_NOOVERLAP);
+    if (sr != sp)
+      why << "NoOverlap has " << sp << " solutions, reference has " << sr;
+    else if (solutions(c, CHECK_INTERVAL) != sr)
+      why << "interval branching finds " << solutions(c, CHECK_INTERVAL)
+          << " solutions, reference has " << sr;
+    return why.str();
+  }
+
+  // Random instance with 2..5 rectangles of size 1..3 on coordinates 0..7
+  static Instance random(std::mt19937& rnd) {
+    std::uniform_int_distribution<int> rects(2, 5), side(1, 3), coord(0, 7), coin(0, 2),
+      container(3, 10);
+    Instance c;
+    int lo = container(rnd), hi = container(rnd);
+    for (int k=std::min(lo, hi); k<=std::max(lo, hi); k++)
+      c.ds.push_back(k);
+    int n = rects(rnd);
+    for (int i=0; i<n; i++) {
+      c.w.push_back(side(rnd));
+      c.h.push_back(side(rnd));
+      for (int d=0; d<2; d++) {
+        // A random interval with some values knocked out
+        int lo = coord(rnd), hi = coord(rnd);
+        if (lo > hi)
+          std::swap(lo, hi);
+        std::vector<int> v;
+        for (int k=lo; k<=hi; k++)
+          if ((k == lo) || (coin(rnd) > 0))
+            v.push_back(k);
+        (d == 0 ? c.dx : c.dy).push_back(v);
+      }
+    }
+    return c;
+  }
+
+  // Greedily make c smaller while the mismatch stays
+  static std::string shrink(Instance& c, std::string why) {
+    bool progress = true;
+    while (progress) {
+      progress = false;
+      for (int i=0; (i<c.size()) && (c.size() > 2) && !progress; i++) {
+        Instance d(c);
+        d.w.erase(d.w.begin()+i); d.h.erase(d.h.begin()+i);
+        d.dx.erase(d.dx.begin()+i); d.dy.erase(d.dy.begin()+i);
+        std::string m = mismatch(d);
+        if (!m.empty()) {
+          c = d; why = m; progress = true;
+        }
+      }
+      for (int i=0; (i<2*c.size()) && !progress; i++) {
+        std::vector<int>& v = (i % 2 == 0) ? c.dx[i/2] : c.dy[i/2];
+        for (size_t k=0; (k<v.size()) && (v.size() > 1) && !progress; k++) {
+          Instance d(c);
+          std::vector<int>& u = (i % 2 == 0) ? d.dx[i/2] : d.dy[i/2];
+          u.erase(u.begin()+k);
+          std::string m = mismatch(d);
+          if (!m.empty()) {
+            c = d; why = m; progress = true;
+          }
+        }
+      }
+    }
+    return why;
+  }
+
+  static void print(std::ostream& os, const Instance& c) {
+    os << "  container: s in {" << c.ds.front() << ".." << c.ds.back() << "}" << std::endl;
+    for (int i=0; i<c.size(); i++) {
+      os << "  rectangle " << i << ": " << c.w[i] << "x" << c.h[i] << ", x in {";
+      for (size_t k=0; k<c.dx[i].size(); k++)
+        os << (k > 0 ? "," : "") << c.dx[i][k];
+      os << "}, y in {";
+      for (size_t k=0; k<c.dy[i].size(); k++)
+        os << (k > 0 ? "," : "") << c.dy[i][k];
+      os << "}" << std::endl;
+    }
+  }
+
+  // Check n random instances, return false and print a counterexample on mismatch
+  static bool run(unsigned int n, unsigned int seed, std::ostream& os) {
+    std::mt19937 rnd(seed);
+    for (unsigned int i=0; i<n; i++) {
+      Instance c = random(rnd);
+      std::string why = mismatch(c);
+      if (!why.empty()) {
+        why = shrink(c, why);
+        os << "mismatch on instance " << i << " (seed " << seed << "): "
+           << why << std::endl;
+        print(os, c);
+        return false;
+      }
+    }
+    os << "checked " << n << " instances, no mismatch" << std::endl;
+    return true;
+  }
+};
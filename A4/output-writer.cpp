@@ -0,0 +1,132 @@
+/*
+ * Authors M&M
+ */
+
+#pragma once
+#include <gecode/search.hh>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace Gecode;
+
+/*
+ * A solution as handed to the writer: the model's values in its own layout (see the
+ * models' snapshot()) and the search statistics at the time it was found.
+ */
+struct OutputSnapshot {
+  std::vector<int> values;
+  Search::Statistics stat;
+};
+
+/*
+ * Writes snapshots on a thread of its own, so the search thread never waits for the
+ * output stream.
+ *
+ * Snapshots travel through a bounded single-producer/single-consumer ring: the
+ * search thread only ever writes the tail and the writer only the head, so neither
+ * takes a lock. When the ring is full push() holds the snapshot back and offers it
+ * again with the next push; a held snapshot is only dropped (and counted) when a
+ * newer one replaces it, and close() waits until the last one is written. put()
+ * always waits for a free slot. The writer polls, sleeping a millisecond when the
+ * ring is empty.
+ */
+class OutputWriter {
+public:
+  typedef void (*Format)(std::ostream&, const OutputSnapshot&);
+protected:
+  std::ostream& os;
+  Format format;
+  std::vector<OutputSnapshot> slot;
+  // Next slot to read (writer) and next slot to fill (search thread)
+  std::atomic<size_t> head, tail;
+  std::atomic<bool> closed;
+  std::atomic<unsigned long int> _dropped, _written;
+  // Newest snapshot the ring had no room for (search thread only)
+  OutputSnapshot held;
+  bool holding;
+  std::thread writer;
+
+  bool enqueue(OutputSnapshot& s) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == slot.size())
+      return false;
+    std::swap(slot[t % slot.size()], s);
+    tail.store(t+1, std::memory_order_release);
+    return true;
+  }
+
+  void run(void) {
+    for (;;) {
+      size_t h = head.load(std::memory_order_relaxed);
+      if (h == tail.load(std::memory_order_acquire)) {
+        if (closed.load(std::memory_order_acquire) &&
+            (h == tail.load(std::memory_order_acquire)))
+          break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        continue;
+      }
+      format(os, slot[h % slot.size()]);
+      _written++;
+      head.store(h+1, std::memory_order_release);
+    }
+    os.flush();
+  }
+
+public:
+  OutputWriter(std::ostream& o, Format f, size_t capacity = 64)
+    : os(o), format(f), slot(capacity), head(0), tail(0), closed(false),
+      _dropped(0), _written(0), holding(false) {
+    writer = std::thread(&OutputWriter::run, this);
+  }
+  ~OutputWriter(void) {
+    close();
+  }
+
+  /*
+   * Hand s to the writer, false if the ring is full and s is held back for now.
+   * Either way s is taken: the caller is left with unspecified contents.
+   */
+  bool push(OutputSnapshot& s) {
+    if (holding && enqueue(held))
+      holding = false;
+    if (!holding && enqueue(s))
+      return true;
+    if (holding)
+      _dropped++;
+    std::swap(held, s);
+    holding = true;
+    return false;
+  }
+  // Hand s to the writer, waiting for room; s is taken as by push()
+  void put(OutputSnapshot& s) {
+    if (holding) {
+      while (!enqueue(held))
+        std::this_thread::yield();
+      holding = false;
+    }
+    while (!enqueue(s))
+      std::this_thread::yield();
+  }
+  // Write what is queued and held back, and stop the writer
+  void close(void) {
+    if (holding) {
+      while (!enqueue(held))
+        std::this_thread::yield();
+      holding = false;
+    }
+    closed.store(true, std::memory_order_release);
+    if (writer.joinable())
+      writer.join();
+  }
+
+  unsigned long int dropped(void) const {
+    return _dropped.load();
+  }
+  unsigned long int written(void) const {
+    return _written.load();
+  }
+};
@@ -0,0 +1,205 @@
+/*
+ * Authors M&M
+ */
+
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Hardware performance counters per solver phase (Linux perf_event_open).
+ *
+ * The counters of the calling thread are opened as one group and read in one go at
+ * the start and end of every phase; the difference is added to the phase. Phases may
+ * nest (NoOverlap propagation and space copies happen inside search), so the search
+ * line includes the lines below it. Events the machine or kernel does not offer are
+ * reported as n/a; without perf support at all every phase reads zero.
+ *
+ * Reading the counters costs two system calls, far more than a NoOverlap propagation
+ * on small instances. Phases entered that often are sampled: only every so many
+ * entries are counted, and the totals are scaled up to all entries. Still life has
+ * no propagators of its own, so its propagation is only part of the search line.
+ *
+ * Counting is per thread: with parallel search only the main thread is counted.
+ */
+class PerfCounters {
+public:
+  enum Event {
+    EV_CYCLES, EV_INSTRUCTIONS, EV_BRANCH_MISSES, EV_LLC_MISSES, EV_DTLB_MISSES,
+    EV_COUNT
+  };
+  enum Phase {
+    PH_BUILD, PH_SEARCH, PH_PROPAGATE, PH_COPY, PH_PRINT,
+    PH_COUNT
+  };
+protected:
+  // Group leader and position of each event in a group read, -1 if not available
+  int leader;
+  int fds[EV_COUNT];
+  int slot[EV_COUNT];
+  int opened;
+  // Accumulated counts, number of times each phase was entered and was counted
+  uint64_t total[PH_COUNT][EV_COUNT];
+  unsigned long int entered[PH_COUNT];
+  unsigned long int calls[PH_COUNT];
+
+  // Counters of the current thread, NULL if not counting
+  static PerfCounters*& current(void) {
+    static thread_local PerfCounters* c = NULL;
+    return c;
+  }
+
+  void open(int e, uint32_t type, uint64_t config) {
+    fds[e] = -1; slot[e] = -1;
+#ifdef __linux__
+    struct perf_event_attr a;
+    memset(&a, 0, sizeof(a));
+    a.size = sizeof(a);
+    a.type = type;
+    a.config = config;
+    a.disabled = (leader < 0) ? 1 : 0;
+    a.exclude_kernel = 1;
+    a.exclude_hv = 1;
+    a.read_format = PERF_FORMAT_GROUP;
+    int fd = static_cast<int>(syscall(__NR_perf_event_open, &a, 0, -1, leader, 0));
+    if (fd < 0)
+      return;
+    if (leader < 0)
+      leader = fd;
+    fds[e] = fd;
+    slot[e] = opened++;
+#else
+    (void) type; (void) config;
+#endif
+  }
+
+  // Read all counters, false if not available
+  bool read(uint64_t v[EV_COUNT]) const {
+    for (int e=EV_COUNT; e--; )
+      v[e] = 0;
+#ifdef __linux__
+    if (leader < 0)
+      return false;
+    uint64_t buf[1 + EV_COUNT];
+    if (::read(leader, buf, sizeof(buf)) < static_cast<ssize_t>(sizeof(uint64_t)))
+      return false;
+    for (int e=EV_COUNT; e--; )
+      if (slot[e] >= 0)
+        v[e] = buf[1 + slot[e]];
+    return true;
+#else
+    return false;
+#endif
+  }
+
+public:
+  PerfCounters(void) : leader(-1), opened(0) {
+    memset(total, 0, sizeof(total));
+    memset(entered, 0, sizeof(entered));
+    memset(calls, 0, sizeof(calls));
+#ifdef __linux__
+    open(EV_CYCLES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    open(EV_INSTRUCTIONS, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    open(EV_BRANCH_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    open(EV_LLC_MISSES, PERF_TYPE_HW_CACHE,
+         PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    open(EV_DTLB_MISSES, PERF_TYPE_HW_CACHE,
+         PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    if (leader >= 0)
+      ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#else
+    for (int e=EV_COUNT; e--; ) {
+      fds[e] = -1; slot[e] = -1;
+    }
+#endif
+    current() = this;
+  }
+  ~PerfCounters(void) {
+    if (current() == this)
+      current() = NULL;
+#ifdef __linux__
+    for (int e=EV_COUNT; e--; )
+      if (fds[e] >= 0)
+        close(fds[e]);
+#endif
+  }
+
+  bool available(void) const {
+    return leader >= 0;
+  }
+
+  /*
+   * Counts the enclosed code as phase p if the thread has counters, costs one
+   * thread-local load otherwise. With every > 1 only one in every entries of p is
+   * counted.
+   */
+  class Scope {
+  protected:
+    PerfCounters* c;
+    Phase p;
+    uint64_t start[EV_COUNT];
+  public:
+    Scope(Phase p0, unsigned int every = 1) : c(current()), p(p0) {
+      if (c != NULL) {
+        if (c->entered[p]++ % every != 0)
+          c = NULL;
+        else
+          c->read(start);
+      }
+    }
+    ~Scope(void) {
+      if (c != NULL) {
+        uint64_t end[EV_COUNT];
+        c->read(end);
+        for (int e=EV_COUNT; e--; )
+          c->total[p][e] += end[e] - start[e];
+        c->calls[p]++;
+      }
+    }
+  };
+
+  void print(std::ostream& os) const {
+    static const char* phases[PH_COUNT] = {
+      "model construction", "search (all)", "  NoOverlap propagation",
+      "  space copy", "solution printing"
+    };
+    static const char* events[EV_COUNT] = {
+      "cycles", "instructions", "branch-misses", "LLC-misses", "dTLB-misses"
+    };
+    if (!available()) {
+      os << "performance counters: not available" << std::endl;
+      return;
+    }
+    for (int p=0; p<PH_COUNT; p++) {
+      if (calls[p] == 0)
+        continue;
+      // Sampled phases are scaled up to all entries
+      double scale = static_cast<double>(entered[p]) / calls[p];
+      os << phases[p] << " (" << entered[p] << "x";
+      if (calls[p] < entered[p])
+        os << ", " << calls[p] << " sampled";
+      os << "):";
+      for (int e=0; e<EV_COUNT; e++) {
+        os << " " << events[e] << "=";
+        if (slot[e] >= 0)
+          os << static_cast<uint64_t>(total[p][e] * scale);
+        else
+          os << "n/a";
+      }
+      if ((slot[EV_CYCLES] >= 0) && (slot[EV_INSTRUCTIONS] >= 0) &&
+          (total[p][EV_CYCLES] > 0))
+        os << " IPC=" << static_cast<double>(total[p][EV_INSTRUCTIONS]) /
+          total[p][EV_CYCLES];
+      os << std::endl;
+    }
+  }
+};
@@ -0,0 +1,86 @@
+/*
+ * Authors M&M
+ */
+
+#pragma once
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/*
+ * Placement of search workers on the machine's NUMA nodes.
+ *
+ * The nodes and their cores are read from /sys/devices/system/node. Worker w goes to
+ * node w % nodes() and is pinned to one of that node's cores, so workers fill the
+ * sockets evenly. Spaces a worker clones after pinning are first touched there and
+ * so live in its node's memory. Without NUMA information (or not on Linux) there is
+ * one node and workers are not pinned.
+ */
+class Placement {
+protected:
+  // Cores of every node
+  std::vector<std::vector<int> > cpus;
+
+  // Parse a cpulist such as "0-15,32-47"
+  static std::vector<int> cpulist(const std::string& l) {
+    std::vector<int> c;
+    std::istringstream in(l);
+    std::string r;
+    while (std::getline(in, r, ',')) {
+      int lo, hi;
+      char dash;
+      std::istringstream ri(r);
+      if (!(ri >> lo))
+        continue;
+      if (!(ri >> dash >> hi))
+        hi = lo;
+      for (int k=lo; k<=hi; k++)
+        c.push_back(k);
+    }
+    return c;
+  }
+
+public:
+  Placement(bool numa) {
+#ifdef __linux__
+    for (int n=0; numa; n++) {
+      std::ostringstream f;
+      f << "/sys/devices/system/node/node" << n << "/cpulist";
+      std::ifstream in(f.str().c_str());
+      std::string l;
+      if (!in || !std::getline(in, l))
+        break;
+      std::vector<int> c = cpulist(l);
+      if (!c.empty())
+        cpus.push_back(c);
+    }
+#else
+    (void) numa;
+#endif
+  }
+
+  unsigned int nodes(void) const {
+    return cpus.empty() ? 1 : static_cast<unsigned int>(cpus.size());
+  }
+  unsigned int node(unsigned int worker) const {
+    return worker % nodes();
+  }
+
+  // Pin the calling thread, worker number w, to a core of its node
+  void pin(unsigned int w) const {
+    if (cpus.empty())
+      return;
+#ifdef __linux__
+    const std::vector<int>& c = cpus[node(w)];
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(c[(w / nodes()) % c.size()], &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+  }
+};
@@ -0,0 +1,200 @@
+/*
+ * Authors M&M
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <ostream>
+
+/*
+ * Thread-local size-class pool for the objects the search engines create and delete
+ * for every node (the spaces themselves).
+ *
+ * Requests up to 4KB are rounded up to a power of two and served from per-thread free
+ * lists that are refilled from 64KB slabs. Slabs are never returned to the system, so a
+ * block freed by a different thread simply joins that thread's free list. Larger requests
+ * and all requests while the pool is disabled go straight to malloc.
+ *
+ * Every block carries a 16 byte header with its size class and requested size, so
+ * blocks can be freed correctly no matter whether the pool was on when they were made.
+ */
+class PoolAllocator {
+public:
+  // Counters reported after search
+  struct Statistics {
+    // Number of allocations and frees
+    unsigned long int alloc, free;
+    // Allocations served from a free list without touching a slab
+    unsigned long int reuse;
+    // Allocations that bypassed the pool
+    unsigned long int large;
+    // Bytes reserved in slabs
+    size_t reserved;
+    // Bytes currently handed out (rounded to size class) and actually requested
+    size_t used, requested;
+    // Internal fragmentation: share of handed out bytes nobody asked for
+    double internal(void) const {
+      return used == 0 ? 0.0 : 1.0 - static_cast<double>(requested) / used;
+    }
+    // External fragmentation: share of slab memory sitting on free lists
+    double external(void) const {
+      return reserved == 0 ? 0.0 : 1.0 - static_cast<double>(used) / reserved;
+    }
+  };
+
+protected:
+  // Smallest class is 16 bytes (2^4), largest 4KB (2^12)
+  static const int min_shift = 4;
+  static const int classes = 9;
+  // Class marker for blocks that came from malloc
+  static const int no_class = -1;
+  static const size_t slab_size = 64 * 1024;
+
+  // Header in front of every block, keeps the payload 16 byte aligned
+  union Header {
+    struct {
+      int cls;
+      size_t size;
+    } info;
+    std::max_align_t align;
+  };
+  // Free list node stored inside a free block
+  struct Block {
+    Block* next;
+  };
+  // Per-thread free lists and current slab
+  struct Cache {
+    Block* free[classes];
+    char* slab;
+    size_t left;
+    Cache(void) : slab(NULL), left(0) {
+      for (int c=classes; c--; )
+        free[c] = NULL;
+    }
+  };
+
+  static Cache& cache(void) {
+    static thread_local Cache c;
+    return c;
+  }
+  static std::atomic<bool>& enabled(void) {
+    static std::atomic<bool> e(false);
+    return e;
+  }
+  struct Counters {
+    std::atomic<unsigned long int> alloc, free, reuse, large;
+    std::atomic<size_t> reserved, used, requested;
+  };
+  static Counters& counters(void) {
+    static Counters c;
+    return c;
+  }
+
+  // Size of class c including its header
+  static size_t block_size(int c) {
+    return static_cast<size_t>(1) << (c + min_shift);
+  }
+  // Smallest class that fits s bytes plus header, or no_class
+  static int size_class(size_t s) {
+    s += sizeof(Header);
+    for (int c=0; c<classes; c++)
+      if (s <= block_size(c))
+        return c;
+    return no_class;
+  }
+  // Cut a fresh block of class c from the thread's slab
+  static void* carve(Cache& k, int c) {
+    size_t b = block_size(c);
+    if (k.left < b) {
+      // Rest of the old slab is lost, at most 4KB per refill
+      k.slab = static_cast<char*>(::malloc(slab_size));
+      if (k.slab == NULL)
+        throw std::bad_alloc();
+      k.left = slab_size;
+      counters().reserved.fetch_add(slab_size, std::memory_order_relaxed);
+    }
+    void* p = k.slab;
+    k.slab += b; k.left -= b;
+    return p;
+  }
+
+public:
+  // Switch the pool on or off, blocks made either way can be freed at any time
+  static void enable(bool b) {
+    enabled().store(b, std::memory_order_relaxed);
+  }
+  static bool active(void) {
+    return enabled().load(std::memory_order_relaxed);
+  }
+
+  static void* alloc(size_t s) {
+    Counters& n = counters();
+    n.alloc.fetch_add(1, std::memory_order_relaxed);
+    int c = active() ? size_class(s) : no_class;
+    Header* h;
+    if (c == no_class) {
+      h = static_cast<Header*>(::malloc(sizeof(Header) + s));
+      if (h == NULL)
+        throw std::bad_alloc();
+      n.large.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      Cache& k = cache();
+      if (k.free[c] != NULL) {
+        h = reinterpret_cast<Header*>(k.free[c]);
+        k.free[c] = k.free[c]->next;
+        n.reuse.fetch_add(1, std::memory_order_relaxed);
+      } else {
+        h = static_cast<Header*>(carve(k, c));
+      }
+      n.used.fetch_add(block_size(c), std::memory_order_relaxed);
+      n.requested.fetch_add(s, std::memory_order_relaxed);
+    }
+    h->info.cls = c;
+    h->info.size = s;
+    return h + 1;
+  }
+
+  static void free(void* p) {
+    if (p == NULL)
+      return;
+    Counters& n = counters();
+    n.free.fetch_add(1, std::memory_order_relaxed);
+    Header* h = static_cast<Header*>(p) - 1;
+    int c = h->info.cls;
+    if (c == no_class) {
+      ::free(h);
+    } else {
+      n.used.fetch_sub(block_size(c), std::memory_order_relaxed);
+      n.requested.fetch_sub(h->info.size, std::memory_order_relaxed);
+      Cache& k = cache();
+      Block* b = reinterpret_cast<Block*>(h);
+      b->next = k.free[c];
+      k.free[c] = b;
+    }
+  }
+
+  static Statistics statistics(void) {
+    Counters& n = counters();
+    Statistics s;
+    s.alloc = n.alloc.load(); s.free = n.free.load();
+    s.reuse = n.reuse.load(); s.large = n.large.load();
+    s.reserved = n.reserved.load();
+    s.used = n.used.load(); s.requested = n.requested.load();
+    return s;
+  }
+
+  static void print(std::ostream& os) {
+    Statistics s = statistics();
+    os << "pool allocations: " << s.alloc << " (reused: " << s.reuse
+       << ", bypassed: " << s.large << ")" << std::endl;
+    os << "pool frees: " << s.free << std::endl;
+    os << "pool reserved: " << s.reserved << " bytes, in use: " << s.used
+       << " bytes" << std::endl;
+    os << "pool fragmentation: internal " << 100.0 * s.internal()
+       << "%, external " << 100.0 * s.external() << "%" << std::endl;
+  }
+};
+
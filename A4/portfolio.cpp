@@ -0,0 +1,115 @@
+/*
+ * Authors M&M
+ */
+
+#pragma once
+#include <gecode/int.hh>
+#include <gecode/search.hh>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <mutex>
+#include <vector>
+
+using namespace Gecode;
+using namespace Gecode::Int;
+
+/*
+ * Support for running several models of one maximization problem side by side, each
+ * with its own engine on its own thread.
+ */
+
+/*
+ * Keeps the objective x above the best value any model has found so far. The value
+ * lives outside the space, so a tighter bound found by another thread shows up the
+ * next time x changes. It only ever cuts off solutions that are no better than one
+ * already found, which is what branch and bound does anyway.
+ */
+class SharedBound : public Propagator {
+protected:
+  // The objective
+  IntView x;
+  // Best value found by any model, INT_MIN if none
+  const std::atomic<int>* best;
+public:
+  SharedBound(Home home, IntView x0, const std::atomic<int>* b)
+    : Propagator(home), x(x0), best(b) {
+    x.subscribe(home,*this,PC_INT_BND);
+  }
+  static ExecStatus post(Home home, IntView x, const std::atomic<int>* b) {
+    (void) new (home) SharedBound(home,x,b);
+    return ES_OK;
+  }
+
+  SharedBound(Space& home, bool share, SharedBound& p)
+    : Propagator(home,share,p), best(p.best) {
+    x.update(home,share,p.x);
+  }
+  virtual Propagator* copy(Space& home, bool share) {
+    return new (home) SharedBound(home,share,*this);
+  }
+
+  virtual PropCost cost(const Space&, const ModEventDelta&) const {
+    return PropCost::unary(PropCost::LO);
+  }
+
+  virtual ExecStatus propagate(Space& home, const ModEventDelta&) {
+    int b = best->load(std::memory_order_relaxed);
+    if (b > INT_MIN)
+      GECODE_ME_CHECK(x.gr(home,b));
+    return x.assigned() ? home.ES_SUBSUMED(*this) : ES_FIX;
+  }
+
+  virtual size_t dispose(Space& home) {
+    x.cancel(home,*this,PC_INT_BND);
+    (void) Propagator::dispose(home);
+    return sizeof(*this);
+  }
+};
+
+/*
+ * Post that x must be larger than the value in best (read whenever x changes).
+ */
+void sharedBound(Home home, IntVar x, const std::atomic<int>& best) {
+  if (home.failed()) return;
+  if (SharedBound::post(home,IntView(x),&best) != ES_OK)
+    home.fail();
+}
+
+/*
+ * Stops a model's engine once some model has finished, that is proven optimality,
+ * or the stop object of the whole portfolio says so. That one is asked at every
+ * node, under the portfolio's mutex, with the statistics summed over all models.
+ */
+class PortfolioStop : public Search::Stop {
+protected:
+  // Number of the model that finished first, -1 while none has
+  const std::atomic<int>& winner;
+  // Stop object of the portfolio, NULL for none
+  Search::Stop* outer;
+  std::mutex* m;
+  // Latest statistics of every model, and the number of this one
+  std::vector<Search::Statistics>* seen;
+  int model;
+public:
+  PortfolioStop(const std::atomic<int>& w, Search::Stop* o = NULL, std::mutex* m0 = NULL,
+                std::vector<Search::Statistics>* s = NULL, int k = 0)
+    : winner(w), outer(o), m(m0), seen(s), model(k) {}
+  virtual bool stop(const Search::Statistics& s, const Search::Options& o) {
+    if (winner.load(std::memory_order_relaxed) >= 0)
+      return true;
+    if (outer == NULL)
+      return false;
+    std::lock_guard<std::mutex> l(*m);
+    (*seen)[model] = s;
+    Search::Statistics t;
+    for (size_t k=0; k<seen->size(); k++) {
+      t.fail += (*seen)[k].fail;
+      t.node += (*seen)[k].node;
+      t.propagate += (*seen)[k].propagate;
+      t.depth = std::max(t.depth, (*seen)[k].depth);
+      t.memory += (*seen)[k].memory;
+    }
+    return outer->stop(t, o);
+  }
+};
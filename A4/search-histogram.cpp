@@ -0,0 +1,239 @@
+/*
+ * Authors M&M
+ */
+
+#pragma once
+#include <gecode/search.hh>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "census.cpp"
+#include "search-monitor.cpp"
+
+using namespace Gecode;
+
+/*
+ * Histograms kept by HistogramEngine next to the usual totals.
+ */
+class SearchHistogram {
+public:
+  // Failures by depth of the failed node
+  std::vector<unsigned long int> fail_depth;
+  // Nodes by number of propagator executions, bucket k holds 2^(k-1)..2^k-1
+  std::vector<unsigned long int> propagate_node;
+  // Nodes by kind of brancher whose choice created them
+  std::map<std::string, unsigned long int> brancher_node;
+
+  void fail(unsigned int depth) {
+    if (fail_depth.size() <= depth)
+      fail_depth.resize(depth+1, 0);
+    fail_depth[depth]++;
+  }
+  void node(unsigned long int propagate, const std::string& brancher) {
+    unsigned int b = 0;
+    while (propagate > 0) {
+      propagate >>= 1; b++;
+    }
+    if (propagate_node.size() <= b)
+      propagate_node.resize(b+1, 0);
+    propagate_node[b]++;
+    brancher_node[brancher]++;
+  }
+
+  void print(std::ostream& os) const {
+    os << "failures by depth:";
+    for (size_t d=0; d<fail_depth.size(); d++)
+      if (fail_depth[d] > 0)
+        os << " " << d << ":" << fail_depth[d];
+    os << std::endl << "nodes by propagations:";
+    for (size_t b=0; b<propagate_node.size(); b++)
+      if (propagate_node[b] > 0) {
+        if (b == 0)
+          os << " 0:";
+        else
+          os << " " << (1UL << (b-1)) << "-" << (1UL << b) - 1 << ":";
+        os << propagate_node[b];
+      }
+    os << std::endl << "nodes by brancher:";
+    for (std::map<std::string, unsigned long int>::const_iterator
+           i=brancher_node.begin(); i != brancher_node.end(); ++i)
+      os << " " << i->first << ":" << i->second;
+    os << std::endl;
+  }
+};
+
+/*
+ * Depth-first engine (best solution search if bab is true) that keeps a
+ * SearchHistogram. It copies every node instead of recomputing, which makes it
+ * slower than Gecode's engines; it is meant for measuring, not for racing.
+ *
+ * T must tell which kind of brancher makes the choice of a propagated space:
+ *   const char* brancher(void) const;
+ * (Gecode does not expose the brancher of a choice, so the model works it out
+ * from the state of its variables.)
+ *
+ * Given a Census (see sample()), every so many nodes that did not fail are counted
+ * into it after propagation. Given a SearchMonitor (see monitor()), the depth of
+ * every node explored is published to it.
+ */
+template<class T, bool bab>
+class HistogramEngine {
+protected:
+  /*
+   * An open node: its space, its choice, the next alternative to explore, and the
+   * number of the best solution its space is constrained by (as Gecode's BAB does,
+   * a child is only constrained again once a better solution has been found)
+   */
+  struct Node {
+    T* s;
+    const Choice* c;
+    unsigned int alt;
+    unsigned int depth;
+    unsigned long int mark;
+    size_t bytes;
+  };
+  std::vector<Node> stack;
+  // Bytes held by the spaces on the stack
+  size_t memory;
+  // Root if it is a solution already, handed out by the first next()
+  T* pending;
+  // Best solution so far and its number, 0 for none (best solution search only)
+  T* best;
+  unsigned long int generation;
+  Search::Statistics stat;
+  SearchHistogram hist;
+  Search::Options opt;
+  bool _stopped;
+  // Census of every every-th node, NULL for none
+  Census* census;
+  unsigned long int every;
+  // Monitor to publish the current depth to, NULL for none
+  SearchMonitor* depths;
+
+  /*
+   * Propagate s, a node at depth d made by brancher b whose space is constrained by
+   * best solution number m; true if it is a solution
+   */
+  bool explore(T* s, unsigned int d, const std::string& b, unsigned long int m) {
+    if (bab && (m < generation))
+      s->constrain(*best);
+    if (depths != NULL)
+      depths->current_depth(d);
+    StatusStatistics ss;
+    SpaceStatus st = s->status(ss);
+    stat.node++;
+    stat.propagate += ss.propagate;
+    if (d > stat.depth)
+      stat.depth = d;
+    hist.node(ss.propagate, b);
+    if ((census != NULL) && (st != SS_FAILED) && (stat.node % every == 0))
+      census->sample(*s);
+    switch (st) {
+    case SS_FAILED:
+      stat.fail++;
+      hist.fail(d);
+      delete s;
+      return false;
+    case SS_SOLVED:
+      return true;
+    case SS_BRANCH:
+    default:
+      {
+        Node n;
+        n.s = s; n.c = s->choice(); n.alt = 0; n.depth = d;
+        n.mark = generation; n.bytes = s->allocated();
+        stack.push_back(n);
+        memory += n.bytes;
+        if (memory > stat.memory)
+          stat.memory = memory;
+      }
+      return false;
+    }
+  }
+
+public:
+  HistogramEngine(T* root, const Search::Options& o = Search::Options::def)
+    : memory(0), pending(NULL), best(NULL), generation(0),
+      opt(o), _stopped(false), census(NULL), every(1), depths(NULL) {
+    T* s = static_cast<T*>(root->clone());
+    if (explore(s, 0, "root", 0))
+      pending = s;
+  }
+  ~HistogramEngine(void) {
+    for (size_t i=0; i<stack.size(); i++) {
+      delete stack[i].c;
+      delete stack[i].s;
+    }
+    delete best;
+    delete pending;
+  }
+
+  // Next solution (next better one for best solution search), NULL if none
+  T* next(void) {
+    if (pending != NULL) {
+      T* s = pending;
+      pending = NULL;
+      return solution(s);
+    }
+    while (!stack.empty()) {
+      if ((opt.stop != NULL) && opt.stop->stop(stat, opt)) {
+        _stopped = true;
+        return NULL;
+      }
+      Node& n = stack.back();
+      unsigned int a = n.alt++;
+      const Choice* c = n.c;
+      unsigned int d = n.depth + 1;
+      unsigned long int m = n.mark;
+      std::string b = n.s->brancher();
+      T* s;
+      if (n.alt == c->alternatives()) {
+        // Last alternative: reuse the node's space
+        s = n.s;
+        memory -= n.bytes;
+        stack.pop_back();
+      } else {
+        s = static_cast<T*>(n.s->clone());
+      }
+      s->commit(*c, a);
+      if (a + 1 == c->alternatives())
+        delete c;
+      if (explore(s, d, b, m))
+        return solution(s);
+    }
+    return NULL;
+  }
+
+  // Count every e-th node into c from now on
+  void sample(Census* c, unsigned long int e) {
+    census = c;
+    every = (e > 0) ? e : 1;
+  }
+
+  // Publish the depth of every node explored to m from now on
+  void monitor(SearchMonitor* m) {
+    depths = m;
+  }
+
+  bool stopped(void) const {
+    return _stopped;
+  }
+  const Search::Statistics& statistics(void) const {
+    return stat;
+  }
+  const SearchHistogram& histogram(void) const {
+    return hist;
+  }
+
+protected:
+  // Hand out solution s, keeping a copy as the bound for best solution search
+  T* solution(T* s) {
+    if (bab) {
+      delete best;
+      best = static_cast<T*>(s->clone());
+      generation++;
+    }
+    return s;
+  }
+};
@@ -0,0 +1,189 @@
+/*
+ * Authors M&M
+ */
+
+#pragma once
+#include <gecode/search.hh>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ostream>
+
+using namespace Gecode;
+
+/*
+ * Stop object that never stops the search, but sees the engine's statistics at every
+ * node. It keeps the latest numbers for others to read and, given an estimate of the
+ * tree size (see TreeEstimate), prints progress and an ETA every so many milliseconds.
+ *
+ * An inner stop object (for node, fail or time limits) can be chained behind it.
+ *
+ * It also keeps the bounds on the objective proven so far: the primal bound (best
+ * solution) and the dual bound (what the search has shown cannot be beaten). Either
+ * may come from another thread. Once both are known the search stops when their
+ * relative gap is at most the gap limit (negative: never).
+ */
+class SearchMonitor : public Search::Stop {
+protected:
+  // Latest statistics seen
+  std::atomic<unsigned long int> _node, _fail, _depth;
+  // Depth of the current node if an engine publishes it (see current_depth()), else -1
+  std::atomic<long> _current;
+  // Estimated tree size, 0 if unknown
+  double estimate;
+  // Milliseconds between progress lines, 0 for none
+  unsigned int interval;
+  // Where progress goes
+  std::ostream& os;
+  // Stop object checked after us
+  Search::Stop* inner;
+  // Time the search started and the last progress line was written
+  std::chrono::steady_clock::time_point start, last;
+  // Number of calls, the clock is only read every 1024 calls
+  unsigned long int calls;
+  // Bounds, valid once the flag is set, and whether the objective is maximized
+  std::atomic<long> _primal, _dual;
+  std::atomic<bool> has_primal, has_dual;
+  // Whether the gap limit stopped the search
+  std::atomic<bool> _gap_stopped;
+  bool maximize;
+  double gap_limit;
+
+  // Move b towards v if that is an improvement (towards larger values if up)
+  static void improve(std::atomic<long>& b, std::atomic<bool>& has, long v, bool up) {
+    if (!has.load()) {
+      b.store(v);
+      has.store(true);
+      return;
+    }
+    long o = b.load();
+    while ((up ? (v > o) : (v < o)) && !b.compare_exchange_weak(o, v))
+      ;
+  }
+
+  double elapsed(std::chrono::steady_clock::time_point now) const {
+    return std::chrono::duration<double>(now - start).count();
+  }
+public:
+  SearchMonitor(std::ostream& os0, double e=0.0, unsigned int i=0,
+                Search::Stop* s=NULL)
+    : _node(0), _fail(0), _depth(0), _current(-1), estimate(e), interval(i), os(os0), inner(s),
+      start(std::chrono::steady_clock::now()), last(start), calls(0),
+      _primal(0), _dual(0), has_primal(false), has_dual(false),
+      _gap_stopped(false), maximize(false), gap_limit(-1.0) {}
+
+  virtual bool stop(const Search::Statistics& s, const Search::Options& o) {
+    _node.store(s.node, std::memory_order_relaxed);
+    _fail.store(s.fail, std::memory_order_relaxed);
+    _depth.store(s.depth, std::memory_order_relaxed);
+    if ((interval > 0) && ((++calls & 1023) == 0)) {
+      std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+      if (std::chrono::duration_cast<std::chrono::milliseconds>(now - last).count()
+          >= interval) {
+        last = now;
+        progress(now);
+      }
+    }
+    if ((gap_limit >= 0.0) && has_primal.load() && has_dual.load() &&
+        (gap() <= gap_limit)) {
+      _gap_stopped.store(true);
+      return true;
+    }
+    return (inner != NULL) && inner->stop(s,o);
+  }
+
+  // Print one progress line
+  void progress(std::chrono::steady_clock::time_point now) const {
+    double t = elapsed(now);
+    unsigned long int n = node();
+    os << "nodes: " << n << ", failures: " << fail() << ", time: " << t << " s";
+    if ((estimate > 0.0) && (n > 0)) {
+      double done = std::min(n / estimate, 0.999);
+      double rate = n / t;
+      double eta = (estimate > n) ? (estimate - n) / rate : 0.0;
+      os << ", progress: " << 100.0 * done << "%, ETA: " << eta << " s";
+    }
+    if (has_primal.load() || has_dual.load()) {
+      os << ", ";
+      bounds(os);
+    }
+    os << std::endl;
+  }
+
+  // Print the bounds and the gap as far as they are known
+  void bounds(std::ostream& os) const {
+    os << "primal: ";
+    if (has_primal.load())
+      os << primal();
+    else
+      os << "none";
+    os << ", dual: ";
+    if (has_dual.load())
+      os << dual();
+    else
+      os << "none";
+    if (has_primal.load() && has_dual.load())
+      os << ", gap: " << 100.0 * gap() << "%";
+  }
+
+  unsigned long int node(void) const {
+    return _node.load(std::memory_order_relaxed);
+  }
+  unsigned long int fail(void) const {
+    return _fail.load(std::memory_order_relaxed);
+  }
+  // Maximum depth reached so far, not the current depth
+  unsigned long int depth(void) const {
+    return _depth.load(std::memory_order_relaxed);
+  }
+  // Depth of the node being explored, only engines that track it publish it
+  void current_depth(unsigned long int d) {
+    _current.store(static_cast<long>(d), std::memory_order_relaxed);
+  }
+  bool current_known(void) const {
+    return _current.load(std::memory_order_relaxed) >= 0;
+  }
+  unsigned long int current_depth(void) const {
+    return static_cast<unsigned long int>(_current.load(std::memory_order_relaxed));
+  }
+  // Direction of the objective and the gap at which to stop
+  void objective(bool max, double limit = -1.0) {
+    maximize = max;
+    gap_limit = limit;
+  }
+  // Publish a solution with objective value v
+  void primal(long v) {
+    improve(_primal, has_primal, v, maximize);
+  }
+  // Publish a proven bound v on the objective
+  void dual(long v) {
+    improve(_dual, has_dual, v, !maximize);
+  }
+  bool gap_stopped(void) const {
+    return _gap_stopped.load();
+  }
+  bool primal_known(void) const {
+    return has_primal.load();
+  }
+  bool dual_known(void) const {
+    return has_dual.load();
+  }
+  long primal(void) const {
+    return _primal.load();
+  }
+  long dual(void) const {
+    return _dual.load();
+  }
+  // Relative gap between the bounds, meaningful once both are known
+  double gap(void) const {
+    long p = primal(), d = dual();
+    return std::abs(static_cast<double>(p - d)) /
+      std::max(std::abs(static_cast<double>(p)), 1.0);
+  }
+
+  // Seconds since the monitor was created
+  double elapsed(void) const {
+    return elapsed(std::chrono::steady_clock::now());
+  }
+};
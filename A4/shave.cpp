@@ -0,0 +1,112 @@
+/*
+ * Authors M&M
+ */
+
+#pragma once
+#include <gecode/int.hh>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+using namespace Gecode;
+
+/*
+ * Shaving: every bound value of every variable the model offers is tried in a copy
+ * of the space; a value whose propagation fails is removed from the space itself.
+ * Removing values moves the bounds, so this is repeated until a round removes
+ * nothing.
+ *
+ * The probes of a round are independent and run on worker threads. Cloning writes
+ * to the space cloned from, so every worker first gets a private copy (made on the
+ * calling thread, without sharing) and clones its probes from that. On one thread
+ * the probes run on the calling thread, cloned from the space itself: shaving
+ * subtree roots inside pinned workers starts no threads.
+ *
+ * T offers its variables by number:
+ *   int shaveSize(void) const;               number of variables
+ *   int shaveMin(int k) const;               bounds of variable k
+ *   int shaveMax(int k) const;
+ *   void shaveRel(int k, IntRelType r, int v);   post variable k r v
+ */
+template<class T>
+class Shaving {
+public:
+  // What a run of shave() did
+  struct Statistics {
+    unsigned long int rounds, probes, removed;
+    double time;
+    Statistics(void) : rounds(0), probes(0), removed(0), time(0) {}
+    void print(std::ostream& os) const {
+      os << "shaving: " << removed << " values removed in " << rounds
+         << " rounds, " << probes << " probes, " << time << " ms" << std::endl;
+    }
+  };
+protected:
+  // A probe: variable k takes value v
+  struct Probe {
+    int k, v;
+    bool fails;
+  };
+  // Try probe p in a clone of c
+  static void run(T* c, Probe& p) {
+    T* d = static_cast<T*>(c->clone());
+    d->shaveRel(p.k, IRT_EQ, p.v);
+    p.fails = d->status() == SS_FAILED;
+    delete d;
+  }
+public:
+  // Shave s on t threads, false if s turns out to fail
+  static bool shave(T* s, unsigned int t, Statistics& st) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    t = std::max(t, 1U);
+    bool ok = s->status() != SS_FAILED;
+    bool changed = true;
+    while (ok && changed) {
+      st.rounds++;
+      std::vector<Probe> probe;
+      for (int k=0; k<s->shaveSize(); k++)
+        if (s->shaveMin(k) < s->shaveMax(k)) {
+          Probe p;
+          p.k = k; p.fails = false;
+          p.v = s->shaveMin(k);
+          probe.push_back(p);
+          p.v = s->shaveMax(k);
+          probe.push_back(p);
+        }
+      st.probes += probe.size();
+      if (t == 1) {
+        for (size_t i=0; i<probe.size(); i++)
+          run(s, probe[i]);
+      } else {
+        std::atomic<size_t> next(0);
+        std::vector<T*> copy(t);
+        for (unsigned int w=0; w<t; w++)
+          copy[w] = static_cast<T*>(s->clone(false));
+        std::vector<std::thread> worker;
+        for (unsigned int w=0; w<t; w++)
+          worker.push_back(std::thread([&, w] {
+            for (size_t i=next++; i<probe.size(); i=next++)
+              run(copy[w], probe[i]);
+          }));
+        for (unsigned int w=0; w<t; w++) {
+          worker[w].join();
+          delete copy[w];
+        }
+      }
+      changed = false;
+      for (size_t i=0; i<probe.size(); i++)
+        if (probe[i].fails) {
+          s->shaveRel(probe[i].k, IRT_NQ, probe[i].v);
+          st.removed++;
+          changed = true;
+        }
+      ok = s->status() != SS_FAILED;
+    }
+    st.time += std::chrono::duration_cast<std::chrono::microseconds>
+      (std::chrono::steady_clock::now() - start).count() / 1000.0;
+    return ok;
+  }
+};
@@ -0,0 +1,286 @@
+/*
+ * Authors M&M
+ */
+
+#pragma once
+#include <gecode/driver.hh>
+#include <algorithm>
+#include <thread>
+
+using namespace Gecode;
+
+/*
+ * Options shared by the square packing and still life drivers: the usual size options
+ * plus the switches for our own search and memory extensions.
+ */
+class SolverOptions : public SizeOptions {
+protected:
+  // Serve space objects from the pooled allocator (pool-alloc.cpp)
+  Driver::BoolOption _pool;
+  // Number of probes for the tree size estimate, 0 for none
+  Driver::UnsignedIntOption _probes;
+  // Only estimate the tree size, do not search
+  Driver::BoolOption _probe_only;
+  // Seed for the probes
+  Driver::UnsignedIntOption _probe_seed;
+  // Milliseconds between progress lines, 0 for none
+  Driver::UnsignedIntOption _progress;
+  // Target for heartbeat telemetry (file or unix:PATH) and its interval
+  Driver::StringValueOption _heartbeat;
+  Driver::UnsignedIntOption _heartbeat_interval;
+  // Number of random instances for the propagator check, 0 for none, and their seed
+  Driver::UnsignedIntOption _check;
+  Driver::UnsignedIntOption _check_seed;
+  // Hardware performance counters per phase
+  Driver::BoolOption _perf;
+  // Search with the histogram engine
+  Driver::BoolOption _histogram;
+  // Table of known still life optima, and whether to only verify them
+  Driver::StringValueOption _optima;
+  Driver::BoolOption _verify;
+  // Deterministic parallel search and the depth at which it splits the tree
+  Driver::BoolOption _deterministic;
+  Driver::UnsignedIntOption _split_depth;
+  // Pin parallel workers to the cores of the NUMA nodes
+  Driver::BoolOption _numa;
+  // Time deterministic search on one worker too and report the speedup
+  Driver::BoolOption _speedup;
+  // Print solutions on a writer thread
+  Driver::BoolOption _async_output;
+  // Relative gap between the bounds at which to stop, negative for never
+  Driver::DoubleOption _gap_limit;
+  // Run all still life models at once, sharing the incumbent
+  Driver::BoolOption _portfolio;
+  // Nodes between census samples, 0 for no census
+  Driver::UnsignedIntOption _census;
+  // Shave the root, and the subtree roots of deterministic search
+  Driver::BoolOption _shave;
+  Driver::BoolOption _shave_subtrees;
+  // Phase saving for value selection, and files to read and write solution hints
+  Driver::BoolOption _phase;
+  Driver::StringValueOption _hints_in;
+  Driver::StringValueOption _hints_out;
+public:
+  SolverOptions(const char* s)
+    : SizeOptions(s),
+      _pool("-pool", "serve space objects from a thread-local pooled allocator", false),
+      _probes("-probes", "random probes for estimating the search tree size", 0),
+      _probe_only("-probe-only", "only estimate the search tree size", false),
+      _probe_seed("-probe-seed", "seed for the tree size probes", 1),
+      _progress("-progress", "milliseconds between progress reports (0: none)", 0),
+      _heartbeat("-heartbeat", "write JSON telemetry lines to a file or unix:PATH (current depth only with -histogram or -census)", NULL),
+      _heartbeat_interval("-heartbeat-interval", "milliseconds between telemetry lines", 1000),
+      _check("-check", "check NoOverlap against the reified model on random instances", 0),
+      _check_seed("-check-seed", "seed for the random check instances", 1),
+      _perf("-perf", "report hardware performance counters per solver phase", false),
+      _histogram("-histogram", "search with an engine that keeps failure/propagation histograms", false),
+      _optima("-optima", "file with known still life optima (default: none)", NULL),
+      _verify("-verify", "post the known still life optimum instead of bounding by it", false),
+      _deterministic("-deterministic", "parallel search with reproducible solutions and statistics", false),
+      _split_depth("-split-depth", "depth at which deterministic search splits the tree", 6),
+      _numa("-numa", "pin parallel workers to NUMA nodes, stealing within a node first", false),
+      _speedup("-speedup", "rerun deterministic search on one worker and report the speedup", false),
+      _async_output("-async-output", "print solutions on a writer thread, dropping some if it falls behind", false),
+      _gap_limit("-gap-limit", "stop once the relative gap between the bounds is at most this (negative: never; still life only)", -1.0),
+      _portfolio("-portfolio", "run all still life models concurrently, the first to prove optimality wins", false),
+      _census("-census", "report what the spaces consist of, sampling every so many nodes (0: no census)", 0),
+      _shave("-shave", "remove bound values that fail by propagation from the root domains", false),
+      _shave_subtrees("-shave-subtrees", "also shave the subtree roots of deterministic search (needs -deterministic)", false),
+      _phase("-phase", "values first take what they were last assigned (phase saving; copies every node instead of recomputing)", false),
+      _hints_in("-hints-in", "file with a solution whose values are taken as saved phases", NULL),
+      _hints_out("-hints-out", "file to write the best solution to as hints", NULL) {
+    add(_pool);
+    add(_probes); add(_probe_only); add(_probe_seed); add(_progress);
+    add(_heartbeat); add(_heartbeat_interval);
+    add(_check); add(_check_seed);
+    add(_perf); add(_histogram);
+    add(_optima); add(_verify);
+    add(_deterministic); add(_split_depth); add(_numa); add(_speedup);
+    add(_async_output); add(_gap_limit);
+    add(_portfolio); add(_census);
+    add(_shave); add(_shave_subtrees);
+    add(_phase); add(_hints_in); add(_hints_out);
+  }
+
+  bool pool(void) const {
+    return _pool.value();
+  }
+  void pool(bool b) {
+    _pool.value(b);
+  }
+
+  // Probe-only mode always probes, 1000 times unless told otherwise
+  unsigned int probes(void) const {
+    return (_probe_only.value() && (_probes.value() == 0)) ? 1000 : _probes.value();
+  }
+  void probes(unsigned int n) {
+    _probes.value(n);
+  }
+  bool probe_only(void) const {
+    return _probe_only.value();
+  }
+  void probe_only(bool b) {
+    _probe_only.value(b);
+  }
+  unsigned int probe_seed(void) const {
+    return _probe_seed.value();
+  }
+  void probe_seed(unsigned int s) {
+    _probe_seed.value(s);
+  }
+  unsigned int progress(void) const {
+    return _progress.value();
+  }
+  void progress(unsigned int ms) {
+    _progress.value(ms);
+  }
+  // Telemetry target, NULL for none
+  const char* heartbeat(void) const {
+    return _heartbeat.value();
+  }
+  unsigned int heartbeat_interval(void) const {
+    return _heartbeat_interval.value();
+  }
+  void heartbeat_interval(unsigned int ms) {
+    _heartbeat_interval.value(ms);
+  }
+
+  unsigned int check(void) const {
+    return _check.value();
+  }
+  void check(unsigned int n) {
+    _check.value(n);
+  }
+  unsigned int check_seed(void) const {
+    return _check_seed.value();
+  }
+  void check_seed(unsigned int s) {
+    _check_seed.value(s);
+  }
+
+  bool perf(void) const {
+    return _perf.value();
+  }
+  void perf(bool b) {
+    _perf.value(b);
+  }
+
+  bool histogram(void) const {
+    return _histogram.value();
+  }
+  void histogram(bool b) {
+    _histogram.value(b);
+  }
+
+  const char* optima(void) const {
+    return _optima.value();
+  }
+  void optima(const char* f) {
+    _optima.value(f);
+  }
+  bool verify(void) const {
+    return _verify.value();
+  }
+  void verify(bool b) {
+    _verify.value(b);
+  }
+
+  bool deterministic(void) const {
+    return _deterministic.value();
+  }
+  void deterministic(bool b) {
+    _deterministic.value(b);
+  }
+  unsigned int split_depth(void) const {
+    return _split_depth.value();
+  }
+  void split_depth(unsigned int d) {
+    _split_depth.value(d);
+  }
+  bool numa(void) const {
+    return _numa.value();
+  }
+  void numa(bool b) {
+    _numa.value(b);
+  }
+  bool speedup(void) const {
+    return _speedup.value();
+  }
+  void speedup(bool b) {
+    _speedup.value(b);
+  }
+  bool async_output(void) const {
+    return _async_output.value();
+  }
+  void async_output(bool b) {
+    _async_output.value(b);
+  }
+  double gap_limit(void) const {
+    return _gap_limit.value();
+  }
+  void gap_limit(double g) {
+    _gap_limit.value(g);
+  }
+  bool portfolio(void) const {
+    return _portfolio.value();
+  }
+  void portfolio(bool b) {
+    _portfolio.value(b);
+  }
+  unsigned int census(void) const {
+    return _census.value();
+  }
+  void census(unsigned int n) {
+    _census.value(n);
+  }
+  bool shave(void) const {
+    return _shave.value();
+  }
+  void shave(bool b) {
+    _shave.value(b);
+  }
+  bool shave_subtrees(void) const {
+    return _shave_subtrees.value();
+  }
+  void shave_subtrees(bool b) {
+    _shave_subtrees.value(b);
+  }
+  // Hints are only read with phase saving, they are its initial phases
+  bool phase(void) const {
+    return _phase.value() || (_hints_in.value() != NULL);
+  }
+  void phase(bool b) {
+    _phase.value(b);
+  }
+  const char* hints_in(void) const {
+    return _hints_in.value();
+  }
+  const char* hints_out(void) const {
+    return _hints_out.value();
+  }
+  // Worker threads for our own parallel engines, -threads 0 means one per core
+  unsigned int workers(void) const {
+    if (threads() >= 1.0)
+      return static_cast<unsigned int>(threads());
+    return std::max(std::thread::hardware_concurrency(), 1U);
+  }
+};
+
+/*
+ * Cutoff sequence for restart-based search as selected by -restart,
+ * -restart-scale and -restart-base, NULL without restarts.
+ */
+inline Search::Cutoff* cutoff(const Options& o) {
+  switch (o.restart()) {
+  case RM_CONSTANT:
+    return Search::Cutoff::constant(o.restart_scale());
+  case RM_LINEAR:
+    return Search::Cutoff::linear(o.restart_scale());
+  case RM_LUBY:
+    return Search::Cutoff::luby(o.restart_scale());
+  case RM_GEOMETRIC:
+    return Search::Cutoff::geometric(o.restart_scale(), o.restart_base());
+  default:
+    return NULL;
+  }
+}
@@ -0,0 +1,189 @@
+/*
+ * Authors M&M
+ */
+
+/*
+ * Library build of both solvers: the driver files are compiled without their main()
+ * and wrapped by the functions declared in solver.hh.
+ */
+#define A4_LIBRARY
+#include "solver.hh"
+#include "SquarePacking.cpp"
+#include "MaximumDensityStillLife.cpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Copy the engine statistics into the result
+template<class Engine>
+static void statistics(SolveStatistics& s, const Engine& e) {
+  Search::Statistics es = e.statistics();
+  s.node = es.node;
+  s.fail = es.fail;
+  s.depth = es.depth;
+  s.propagate = es.propagate;
+  s.memory = es.memory;
+}
+
+/*
+ * Stop object for a call: stops when the caller's cancel flag is set, or when
+ * the time limit runs out.
+ */
+class CallStop : public Search::Stop {
+protected:
+  const std::atomic<bool>* cancel;
+  Search::TimeStop* time;
+public:
+  CallStop(const SolveOptions& o)
+    : cancel(o.cancel),
+      time((o.time > 0) ? new Search::TimeStop(o.time) : NULL) {}
+  virtual bool stop(const Search::Statistics& s, const Search::Options& o) {
+    return ((cancel != NULL) && cancel->load(std::memory_order_relaxed)) ||
+      ((time != NULL) && time->stop(s,o));
+  }
+  ~CallStop(void) {
+    delete time;
+  }
+};
+
+// Search options for a call
+static Search::Options searchOptions(const SolveOptions& o, Search::Stop* st) {
+  Search::Options so;
+  so.threads = o.threads;
+  so.stop = st;
+  return so;
+}
+
+PackingResult solvePacking(int n, const SolveOptions& o) {
+  Support::Timer t;
+  t.start();
+  PackingResult r;
+  SolverOptions so("Square packing");
+  so.size(n);
+  so.model(o.model);
+  so.branching(o.branching);
+  CallStop cs(o);
+
+  SquarePacking* sp = new SquarePacking(so);
+  DFS<SquarePacking> dfs(sp, searchOptions(o, &cs));
+  delete sp;
+  if (SquarePacking* q = dfs.next()) {
+    r.solved = true;
+    r.s = q->s.val();
+    for (int i=0; i<q->X.size(); i++) {
+      r.x.push_back(q->X[i].val());
+      r.y.push_back(q->Y[i].val());
+    }
+    delete q;
+  }
+  statistics(r.statistics, dfs);
+  r.statistics.runtime = t.stop();
+  return r;
+}
+
+StillLifeResult solveStillLife(int n, const SolveOptions& o) {
+  Support::Timer t;
+  t.start();
+  StillLifeResult r;
+  SolverOptions so("Maximum Density Still Life");
+  so.size(n);
+  CallStop cs(o);
+
+  MaximumDensityStillLife* mdsl = new MaximumDensityStillLife(so);
+  BAB<MaximumDensityStillLife> bab(mdsl, searchOptions(o, &cs));
+  delete mdsl;
+  // Every solution improves on the previous one, keep the last
+  while (MaximumDensityStillLife* q = bab.next()) {
+    r.solved = true;
+    r.lives = q->lives();
+    r.cells.assign(n*n, false);
+    for (int row=0; row<n; row++)
+      for (int col=0; col<n; col++)
+        r.cells[row*n + col] = q->alive(col, row);
+    delete q;
+  }
+  r.optimal = r.solved && !bab.stopped();
+  statistics(r.statistics, bab);
+  r.statistics.runtime = t.stop();
+  return r;
+}
+
+/*
+ * Work queue shared by the executor's workers.
+ */
+class SolveExecutor::Queue {
+public:
+  std::mutex m;
+  std::condition_variable cv;
+  std::deque<std::function<void(void)> > jobs;
+  std::vector<std::thread> workers;
+  bool done;
+
+  Queue(void) : done(false) {}
+
+  void work(void) {
+    for (;;) {
+      std::function<void(void)> job;
+      {
+        std::unique_lock<std::mutex> l(m);
+        cv.wait(l, [this] { return done || !jobs.empty(); });
+        // Drain the queue before leaving, nobody is left with a broken promise
+        if (jobs.empty())
+          return;
+        job = jobs.front();
+        jobs.pop_front();
+      }
+      job();
+    }
+  }
+
+  template<class Result>
+  SolveHandle<Result> submit(Result (*solve)(int, const SolveOptions&),
+                             int n, const SolveOptions& o) {
+    std::shared_ptr<std::atomic<bool> > c(new std::atomic<bool>(false));
+    SolveOptions oc(o);
+    oc.cancel = c.get();
+    // The job keeps the flag alive for as long as the search may look at it
+    std::shared_ptr<std::packaged_task<Result(void)> > task
+      (new std::packaged_task<Result(void)>([solve, n, oc, c] {
+        return solve(n, oc);
+      }));
+    SolveHandle<Result> h(task->get_future().share(), c);
+    {
+      std::lock_guard<std::mutex> l(m);
+      jobs.push_back([task] { (*task)(); });
+    }
+    cv.notify_one();
+    return h;
+  }
+};
+
+SolveExecutor::SolveExecutor(unsigned int w) : queue(new Queue) {
+  if (w == 0)
+    w = std::max(std::thread::hardware_concurrency(), 1U);
+  for (unsigned int i=0; i<w; i++)
+    queue->workers.push_back(std::thread(&Queue::work, queue));
+}
+
+SolveExecutor::~SolveExecutor(void) {
+  {
+    std::lock_guard<std::mutex> l(queue->m);
+    queue->done = true;
+  }
+  queue->cv.notify_all();
+  for (size_t i=0; i<queue->workers.size(); i++)
+    queue->workers[i].join();
+  delete queue;
+}
+
+SolveHandle<PackingResult>
+SolveExecutor::solvePacking(int n, const SolveOptions& o) {
+  return queue->submit(&::solvePacking, n, o);
+}
+
+SolveHandle<StillLifeResult>
+SolveExecutor::solveStillLife(int n, const SolveOptions& o) {
+  return queue->submit(&::solveStillLife, n, o);
+}
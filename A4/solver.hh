@@ -0,0 +1,127 @@
+/*
+ * Authors M&M
+ */
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <vector>
+
+/*
+ * In-process entry points for the square packing and still life solvers.
+ *
+ * The functions write nothing to stdout or stderr, keep no state between calls and
+ * may be called from several threads at once; every call builds and searches its own
+ * spaces. Link solver.cpp (with Gecode) instead of the two driver programs.
+ */
+
+// Models and branchings, same numbering as the drivers' -model and -branching
+enum PackingModel {
+  PACKING_REIFY, PACKING_NOOVERLAP
+};
+enum PackingBranching {
+  PACKING_VALUE_ORDER, PACKING_CONTACT
+};
+
+struct SolveOptions {
+  // Model and branching of the square packing solver
+  PackingModel model;
+  PackingBranching branching;
+  // Give up after so many milliseconds, 0 for no limit
+  unsigned long int time;
+  // Number of search threads, 1 for sequential search
+  unsigned int threads;
+  // Search stops as soon as this flag is set (may be NULL)
+  const std::atomic<bool>* cancel;
+  SolveOptions(void)
+    : model(PACKING_NOOVERLAP), branching(PACKING_VALUE_ORDER),
+      time(0), threads(1), cancel(NULL) {}
+};
+
+struct SolveStatistics {
+  unsigned long int node, fail, depth, propagate;
+  unsigned long int memory;
+  // Wall clock time of the call in milliseconds
+  double runtime;
+  SolveStatistics(void)
+    : node(0), fail(0), depth(0), propagate(0), memory(0), runtime(0.0) {}
+};
+
+struct PackingResult {
+  // Whether a packing was found (false if stopped by time limit or cancellation)
+  bool solved;
+  // Side of the enclosing square
+  int s;
+  // Lower left corners of the squares of size n, n-1, ..., 2 (size 1 is left out)
+  std::vector<int> x, y;
+  SolveStatistics statistics;
+  PackingResult(void) : solved(false), s(0) {}
+};
+
+struct StillLifeResult {
+  // Whether any still life was found, and whether the best one is proven optimal
+  bool solved, optimal;
+  // Number of live cells in the best still life
+  int lives;
+  // Best still life, row-major n*n
+  std::vector<bool> cells;
+  SolveStatistics statistics;
+  StillLifeResult(void) : solved(false), optimal(false), lives(0) {}
+};
+
+// Pack squares 1x1 ... nxn into the smallest enclosing square
+PackingResult solvePacking(int n, const SolveOptions& o = SolveOptions());
+
+// Find a maximum density still life on an n x n board
+StillLifeResult solveStillLife(int n, const SolveOptions& o = SolveOptions());
+
+/*
+ * Handle for a solve running on a SolveExecutor: a shared future for the result plus
+ * the flag that cancels the search. A cancelled solve still delivers a result, holding
+ * whatever was found until the engine noticed the flag.
+ */
+template<class Result>
+class SolveHandle {
+protected:
+  std::shared_future<Result> result;
+  std::shared_ptr<std::atomic<bool> > cancelled;
+public:
+  SolveHandle(std::shared_future<Result> r, std::shared_ptr<std::atomic<bool> > c)
+    : result(r), cancelled(c) {}
+  // Ask the search to stop at its next node
+  void cancel(void) {
+    cancelled->store(true);
+  }
+  bool ready(void) const {
+    return result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  }
+  // Wait for and return the result
+  const Result& get(void) const {
+    return result.get();
+  }
+  const std::shared_future<Result>& future(void) const {
+    return result;
+  }
+};
+
+/*
+ * Fixed pool of worker threads that runs solves in submission order. Destroying the
+ * executor waits for all submitted solves, cancel their handles first to make it quick.
+ */
+class SolveExecutor {
+protected:
+  class Queue;
+  Queue* queue;
+public:
+  // Start w workers, 0 for one per hardware thread
+  explicit SolveExecutor(unsigned int w=0);
+  ~SolveExecutor(void);
+
+  SolveHandle<PackingResult> solvePacking(int n, const SolveOptions& o = SolveOptions());
+  SolveHandle<StillLifeResult> solveStillLife(int n, const SolveOptions& o = SolveOptions());
+private:
+  SolveExecutor(const SolveExecutor&);
+  SolveExecutor& operator =(const SolveExecutor&);
+};